@@ -0,0 +1,27 @@
+#pragma once
+
+#include <ostream>
+
+// Allocation accounting, compiled in with -DGAME_ALLOC_PROFILE=ON. The build
+// then replaces the global operator new and counts allocations and bytes
+// under the innermost AllocationTag of the calling thread. Tags must be
+// string literals: they are told apart by address. Without the option a tag
+// is an empty object, and reportAllocations prints nothing.
+class AllocationTag {
+#if defined(GAME_ALLOC_PROFILE)
+ private:
+  const char* previous;
+
+ public:
+  explicit AllocationTag(const char*);
+  ~AllocationTag();
+#else
+ public:
+  explicit AllocationTag(const char*) {}
+#endif
+  AllocationTag(const AllocationTag&) = delete;
+  AllocationTag& operator=(const AllocationTag&) = delete;
+};
+
+bool allocationProfilingEnabled();
+void reportAllocations(std::ostream&);
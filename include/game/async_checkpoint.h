@@ -0,0 +1,52 @@
+#pragma once
+
+#include "game/session.h"
+#include "game/world.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+// Cost of one forked checkpoint. pause is how long the caller was stopped
+// (the fork itself), duration runs from the fork until the child has written
+// and renamed the snapshot. copiedPages counts the parent's minor page
+// faults in between, which is mostly copy-on-write copies of pages the
+// simulation touched while the child was writing.
+struct CheckpointStats {
+  std::chrono::nanoseconds pause{0};
+  std::chrono::nanoseconds duration{0};
+  uint64_t copiedPages = 0;
+  bool succeeded = false;
+};
+
+// Writes world snapshots from a forked child, which sees the world frozen
+// at the moment of the fork while the parent keeps simulating. The snapshot
+// goes to <path>.tmp and is renamed over path when complete, so path always
+// holds a whole snapshot, stamped with the session position it was taken
+// at. One checkpoint runs at a time. Start checkpoints
+// from the simulation thread, since the child copies only that thread.
+class AsyncCheckpointer {
+ private:
+  pid_t child;
+  std::chrono::steady_clock::time_point started;
+  uint64_t faultsAtStart;
+  CheckpointStats current;
+  CheckpointStats last;
+  uint64_t completed;
+
+  void collect(int);
+
+ public:
+  AsyncCheckpointer();
+  AsyncCheckpointer(const AsyncCheckpointer&) = delete;
+  AsyncCheckpointer& operator=(const AsyncCheckpointer&) = delete;
+  ~AsyncCheckpointer();
+  bool start(const World&, const std::string&, SessionPosition = {});
+  bool running() const;
+  bool poll();
+  void wait();
+  uint64_t getCompleted() const;
+  const CheckpointStats& getLast() const;
+};
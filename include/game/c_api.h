@@ -0,0 +1,57 @@
+#pragma once
+
+/* C ABI over GameSession. No function throws, and none allocates on the use
+   and query paths; failures are reported as game_error values, and
+   game_session_create returns NULL when the session cannot be built. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct game_session game_session;
+
+typedef enum game_error {
+  GAME_OK,
+  GAME_CONTAINER_FULL,
+  GAME_ITEM_NOT_FOUND,
+  GAME_NOT_OWNER,
+  GAME_ITEM_USED,
+  GAME_INVALID_TARGET,
+  GAME_INVALID_VALUE,
+  GAME_INVALID_HANDLE,
+  GAME_OUT_OF_MEMORY
+} game_error;
+
+typedef enum game_item_kind { GAME_WEAPON, GAME_POTION, GAME_SPELL } game_item_kind;
+
+typedef struct game_inventory_entry {
+  const char* name;
+  uint32_t name_length;
+  int32_t value;
+} game_inventory_entry;
+
+game_session* game_session_create(uint32_t max_characters, int32_t container_capacity);
+void game_session_destroy(game_session* session);
+
+game_error game_create_character(game_session* session, const char* name, int32_t health_points, uint32_t* handle);
+game_error game_create_weapon(game_session* session, uint32_t owner, const char* name, int32_t damage);
+game_error game_create_potion(game_session* session, uint32_t owner, const char* name, int32_t heal_value);
+game_error game_create_spell(game_session* session, uint32_t owner, const char* name, const uint32_t* targets,
+                             uint32_t target_count);
+/* Replaces the item's fixed value with a formula such as "base + roll(6)";
+   an empty formula restores the fixed value. */
+game_error game_set_effect(game_session* session, game_item_kind kind, uint32_t owner, const char* item,
+                           const char* formula);
+
+game_error game_use(game_session* session, game_item_kind kind, uint32_t user, uint32_t target, const char* item);
+game_error game_health(const game_session* session, uint32_t handle, int32_t* health_points);
+/* Writes up to capacity entries and returns the total number of items. */
+uint32_t game_inventory(const game_session* session, uint32_t handle, game_item_kind kind,
+                        game_inventory_entry* entries, uint32_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "game/name.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+struct World;
+class Character;
+class PhysicalItem;
+class Weapon;
+class Potion;
+class Spell;
+class CharacterObserver {
+ public:
+  virtual ~CharacterObserver() = default;
+  virtual void onHealthChanged(const Character&, int) = 0;
+};
+class ContainerObserver {
+ public:
+  virtual ~ContainerObserver() = default;
+  virtual void onItemAdded(const PhysicalItem&) = 0;
+  virtual void onItemRemoved(const PhysicalItem&) = 0;
+  virtual void onItemConsumed(const PhysicalItem&) = 0;
+};
+// Whoever appends a character to a World reports it with onCharacterAdded,
+// after the character and its three containers are in place.
+class WorldObserver : public CharacterObserver, public ContainerObserver {
+ public:
+  virtual void onCharacterAdded(const World&, uint32_t) {}
+};
+
+class Character {
+ private:
+  int healthPoints;
+  Name name;
+  CharacterObserver* observer;
+
+ protected:
+  void obtainItemSideEffect(const PhysicalItem&);
+  void loseItemSideEffect(const PhysicalItem&);
+  friend std::ostream& operator<<(std::ostream& out, const Character&);
+
+ public:
+  Character();
+  Character(const Name&, int);
+  Character(const Character&);
+  Character& operator=(const Character&);
+  void setObserver(CharacterObserver*);
+  int getHP() const;
+  const Name& getName() const;
+  void takeDamage(int);
+  void heal(int);
+};
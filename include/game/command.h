@@ -0,0 +1,208 @@
+#pragma once
+
+#include "game/session.h"
+#include "game/world.h"
+#include "game/world_index.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class Keyword : uint8_t {
+  Create,
+  Attack,
+  Cast,
+  Drink,
+  Dialogue,
+  Show,
+  Query,
+  Character,
+  Item,
+  Weapon,
+  Potion,
+  Spell,
+  Fighter,
+  Archer,
+  Wizard,
+  Characters,
+  Weapons,
+  Potions,
+  Spells,
+  Unknown,
+};
+inline constexpr size_t keywordCount = static_cast<size_t>(Keyword::Unknown);
+inline constexpr std::array<std::string_view, keywordCount> keywordNames = {
+    "Create", "Attack",  "Cast",   "Drink",  "Dialogue",   "Show",    "Query",   "character", "item",   "weapon",
+    "potion", "spell",   "fighter", "archer", "wizard",    "characters", "weapons", "potions", "spells",
+};
+
+// Perfect hash over the keyword set. Every keyword differs from the others
+// in its length, first or last character, so those three are packed and
+// multiplied by a constant that the compiler searches for at build time
+// until no two keywords share a slot. A lookup is one multiply, one table
+// read and one string comparison to reject words outside the set.
+namespace keyword_hash {
+
+inline constexpr unsigned tableBits = 6;
+
+constexpr uint64_t features(std::string_view word) {
+  return word.size() | static_cast<uint64_t>(static_cast<unsigned char>(word.front())) << 8 |
+         static_cast<uint64_t>(static_cast<unsigned char>(word.back())) << 16;
+}
+constexpr size_t slot(std::string_view word, uint64_t multiplier) {
+  return static_cast<size_t>((features(word) * multiplier) >> (64 - tableBits));
+}
+constexpr bool isPerfect(uint64_t multiplier) {
+  std::array<bool, size_t{1} << tableBits> used{};
+  for (std::string_view name : keywordNames) {
+    if (used[slot(name, multiplier)])
+      return false;
+    used[slot(name, multiplier)] = true;
+  }
+  return true;
+}
+constexpr uint64_t findMultiplier() {
+  uint64_t candidate = 0x9E3779B97F4A7C15ull;
+  while (!isPerfect(candidate))
+    candidate += 0x6A09E667F3BCC909ull;
+  return candidate;
+}
+inline constexpr uint64_t multiplier = findMultiplier();
+
+constexpr std::array<Keyword, size_t{1} << tableBits> buildTable() {
+  std::array<Keyword, size_t{1} << tableBits> table{};
+  table.fill(Keyword::Unknown);
+  for (size_t index = 0; index < keywordCount; ++index)
+    table[slot(keywordNames[index], multiplier)] = static_cast<Keyword>(index);
+  return table;
+}
+inline constexpr std::array<Keyword, size_t{1} << tableBits> table = buildTable();
+
+}  // namespace keyword_hash
+
+constexpr Keyword keywordOf(std::string_view word) {
+  if (word.empty())
+    return Keyword::Unknown;
+  Keyword keyword = keyword_hash::table[keyword_hash::slot(word, keyword_hash::multiplier)];
+  if (keyword == Keyword::Unknown || keywordNames[static_cast<size_t>(keyword)] != word)
+    return Keyword::Unknown;
+  return keyword;
+}
+static_assert(keywordOf("Dialogue") == Keyword::Dialogue && keywordOf("spells") == Keyword::Spells);
+static_assert(keywordOf("Query") == Keyword::Query);
+static_assert(keywordOf("Spells") == Keyword::Unknown && keywordOf("") == Keyword::Unknown);
+
+// The straightforward comparison chain the hash replaces; kept as the
+// baseline for benchmarkKeywords.
+Keyword keywordByComparison(std::string_view);
+void benchmarkKeywords(size_t, std::ostream&);
+
+// One whitespace-separated token, as a position in the text it came from.
+struct TokenRef {
+  uint32_t offset;
+  uint32_t length;
+};
+// One non-empty line: its first word's keyword and the tokens after it.
+struct CommandRecord {
+  Keyword keyword;
+  uint32_t firstToken;
+  uint32_t tokenCount;
+};
+// Parsed commands for a stretch of text, in line order. Token offsets are
+// relative to text, which must outlive the batch, so a stretch is limited
+// to 4 GiB.
+struct CommandBatch {
+  std::string_view text;
+  std::vector<CommandRecord> records;
+  std::vector<TokenRef> tokens;
+};
+void parseCommands(std::string_view, CommandBatch&);
+
+class TokenCursor {
+ private:
+  std::string_view text;
+  const TokenRef* position;
+  const TokenRef* end;
+
+ public:
+  TokenCursor(std::string_view, const TokenRef*, const TokenRef*);
+  std::string_view next();
+  bool atEnd() const;
+};
+
+// Runs text commands in the classic input format, one per line:
+//   Create character <fighter|archer|wizard> <name> <hp>
+//   Create item <weapon|potion> <owner> <name> <value>
+//   Create item spell <owner> <name> <target-count> <target>...
+//   Attack <user> <target> <weapon>    Cast <user> <target> <spell>
+//   Drink <supplier> <drinker> <potion>
+//   Dialogue <speaker> <word-count> <word>...
+//   Show characters | Show <weapons|potions|spells> <owner>
+//   Query HP below <n> | Query HP between <min> <max> | Query Owners <item>
+// The first word selects the handler through a jump table indexed by its
+// keyword. Invalid commands print "Error caught". Attack, Cast and Drink
+// number their combat rolls from the given first sequence, so a run resumed
+// mid-log passes the count of such commands already executed. Parsing is separate from
+// execution: lines can be parsed into a CommandBatch elsewhere, for example
+// on other threads, and then executed in order. Query answers from a
+// WorldIndex built on the first Query and kept current through the world's
+// observers from then on. setObserver attaches one more observer, such as a
+// DeltaWriter, which also hears about characters created later. After
+// deferUses, valid Attack, Cast and Drink commands are appended to the given
+// list as numbered SessionEvents instead of running.
+class CommandInterpreter {
+ private:
+  using Handler = bool (CommandInterpreter::*)(TokenCursor&);
+  World& world;
+  std::ostream& out;
+  std::unordered_map<Name, uint32_t> handles;
+  uint64_t sequence;
+  CommandBatch lineBatch;
+  std::unique_ptr<WorldIndex> index;
+  WorldObserver* observer;
+  WorldObservers observers;
+  std::vector<SessionEvent>* deferred;
+
+  WorldObserver* attached();
+  void attach();
+  bool handleOf(std::string_view, uint32_t&) const;
+  bool create(TokenCursor&);
+  bool createCharacter(TokenCursor&);
+  bool createItem(TokenCursor&);
+  bool attack(TokenCursor&);
+  bool cast(TokenCursor&);
+  bool drink(TokenCursor&);
+  bool use(ItemKind, TokenCursor&);
+  bool dialogue(TokenCursor&);
+  bool show(TokenCursor&);
+  bool query(TokenCursor&);
+  bool unknown(TokenCursor&);
+  static constexpr std::array<Handler, keywordCount + 1> handlers = {
+      &CommandInterpreter::create, &CommandInterpreter::attack,   &CommandInterpreter::cast,
+      &CommandInterpreter::drink,  &CommandInterpreter::dialogue, &CommandInterpreter::show,
+      &CommandInterpreter::query, &CommandInterpreter::unknown, &CommandInterpreter::unknown,
+      &CommandInterpreter::unknown, &CommandInterpreter::unknown, &CommandInterpreter::unknown,
+      &CommandInterpreter::unknown, &CommandInterpreter::unknown, &CommandInterpreter::unknown,
+      &CommandInterpreter::unknown, &CommandInterpreter::unknown, &CommandInterpreter::unknown,
+      &CommandInterpreter::unknown, &CommandInterpreter::unknown,
+  };
+
+ public:
+  CommandInterpreter(World&, std::ostream&, uint64_t = 0);
+  CommandInterpreter(const CommandInterpreter&) = delete;
+  CommandInterpreter& operator=(const CommandInterpreter&) = delete;
+  ~CommandInterpreter();
+  void setObserver(WorldObserver*);
+  void deferUses(std::vector<SessionEvent>*);
+  void execute(std::string_view);
+  void execute(const CommandBatch&, const CommandRecord&);
+  void execute(const CommandBatch&);
+  void run(std::istream&);
+};
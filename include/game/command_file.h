@@ -0,0 +1,47 @@
+#pragma once
+
+#include "game/command.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only mapping of a whole file; an empty file maps to an empty view.
+class MappedFile {
+ private:
+  void* address;
+  size_t length;
+
+ public:
+  explicit MappedFile(const std::string&);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+  std::string_view text() const;
+};
+
+// Splits text at line boundaries into one chunk per thread and parses the
+// chunks concurrently into batches, which keep the text's line order.
+void parseChunks(std::string_view, std::vector<CommandBatch>&, size_t);
+
+// Parses command text window by window, so only one window's tokens are held
+// at a time. Each window is parsed with parseChunks on all threads while the
+// batches of the previous one are handed, in order, to the callback on the
+// calling thread. threads == 0 uses every hardware thread. The callback
+// returns false to stop early, and the call then returns false.
+bool forEachCommandBatch(std::string_view, const std::function<bool(const CommandBatch&)>&, size_t = 0,
+                         size_t = size_t{64} << 20);
+// Runs command text through forEachCommandBatch.
+void runCommandText(std::string_view, CommandInterpreter&, size_t = 0, size_t = size_t{64} << 20);
+
+// The same for an LZ4-compressed command file (see game/lz4.h). A window of
+// blocks is decompressed on all threads while the previous window is parsed
+// and executed, and a line cut by a window edge is carried into the next
+// one. Throws on a corrupt archive.
+bool forEachCompressedBatch(std::string_view, const std::function<bool(const CommandBatch&)>&, size_t = 0);
+void runCompressedCommands(std::string_view, CommandInterpreter&, size_t = 0);
+// Pick the compressed variants for LZ4 frames and the text ones otherwise.
+bool forEachInputBatch(std::string_view, const std::function<bool(const CommandBatch&)>&, size_t = 0);
+void runCommandInput(std::string_view, CommandInterpreter&, size_t = 0);
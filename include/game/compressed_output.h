@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Output sink that compresses in a background thread. Text is collected in
+// blocks, and each full block (or whatever is buffered at a flush) is
+// written to the target as a self-contained LZ4 frame, so any frame decodes
+// on its own and a cut-off file loses at most the frame being written. At
+// most queueDepth blocks wait for the compressor; past that, writers block
+// instead of buffering without limit.
+class CompressingStreamBuffer : public std::streambuf {
+ private:
+  std::ostream& target;
+  size_t blockSize;
+  size_t queueDepth;
+  std::vector<char> filling;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::vector<char>> pending;
+  std::vector<std::vector<char>> spare;
+  bool closing;
+  bool finished;
+  uint64_t bytesIn;
+  uint64_t bytesOut;
+  std::thread worker;
+
+  void submit();
+  void compressLoop();
+
+ protected:
+  int_type overflow(int_type) override;
+  int sync() override;
+
+ public:
+  explicit CompressingStreamBuffer(std::ostream&, size_t = size_t{1} << 20, size_t = 4);
+  CompressingStreamBuffer(const CompressingStreamBuffer&) = delete;
+  CompressingStreamBuffer& operator=(const CompressingStreamBuffer&) = delete;
+  ~CompressingStreamBuffer() override;
+  void finish();
+  uint64_t uncompressedBytes() const;
+  uint64_t compressedBytes() const;
+};
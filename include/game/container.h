@@ -0,0 +1,198 @@
+#pragma once
+
+#include "game/alloc_profile.h"
+#include "game/error.h"
+#include "game/hash_trie.h"
+#include "game/item.h"
+#include "game/name.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename CurClass>
+concept PhysicalDerived = std::is_base_of<PhysicalItem, CurClass>::value;
+
+// Items live in a persistent hash array mapped trie (game/hash_trie.h), so
+// copying a container is O(1) and the copy shares every node. add and remove
+// on either then copy only the O(log32 n) shared nodes on the item's path,
+// leaving the other copies intact: each copy is a version that stays cheap
+// to keep and query. A container nobody copied is updated in place.
+// Iteration visits items in name order; begin() sorts them, O(n log n).
+template <PhysicalDerived T>
+class Container {
+ public:
+  using value_type = std::pair<Name, T>;
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<Name, T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+   private:
+    std::shared_ptr<const std::vector<const value_type*>> order;
+    size_t index;
+
+   public:
+    const_iterator() : order(), index(0) {}
+    const_iterator(std::shared_ptr<const std::vector<const value_type*>> order, size_t index)
+        : order(std::move(order)), index(index) {}
+    reference operator*() const { return *(*order)[index]; }
+    pointer operator->() const { return (*order)[index]; }
+    const_iterator& operator++() {
+      ++index;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++index;
+      return previous;
+    }
+    bool operator==(const const_iterator& other) const { return index == other.index; }
+  };
+
+ protected:
+  HashTrie<T> elements;
+  ContainerObserver* observer = nullptr;
+
+ public:
+  Container() = default;
+  Container(const Container&);
+  Container& operator=(const Container&);
+  virtual ~Container() = default;
+  void setObserver(ContainerObserver*);
+  virtual ErrorCode add(T);
+  ErrorCode remove(T);
+  ErrorCode remove(const Name&);
+  bool find(T) const;
+  std::optional<T> find(const Name&) const;
+  size_t size() const;
+  const_iterator begin() const;
+  const_iterator end() const;
+};
+template <PhysicalDerived T>
+Container<T>::Container(const Container& other) : elements(other.elements) {}
+template <PhysicalDerived T>
+Container<T>& Container<T>::operator=(const Container& other) {
+  elements = other.elements;
+  return *this;
+}
+// Stored items are shared between versions, so the observer reaches items
+// through find(), which hands out copies that carry it.
+template <PhysicalDerived T>
+void Container<T>::setObserver(ContainerObserver* containerObserver) {
+  observer = containerObserver;
+}
+template <PhysicalDerived T>
+ErrorCode Container<T>::add(T item) {
+  AllocationTag tag("Container::add");
+  Name itemName = item.getName();
+  item.setObserver(nullptr);
+  std::optional<T> replaced;
+  if (const value_type* existing = elements.find(itemName); existing != nullptr && observer != nullptr)
+    replaced = existing->second;
+  elements.set(itemName, std::move(item));
+  if (observer == nullptr)
+    return ErrorCode::Ok;
+  if (replaced)
+    observer->onItemRemoved(*replaced);
+  observer->onItemAdded(elements.find(itemName)->second);
+  return ErrorCode::Ok;
+}
+template <PhysicalDerived T>
+ErrorCode Container<T>::remove(T item) {
+  return remove(item.getName());
+}
+template <PhysicalDerived T>
+ErrorCode Container<T>::remove(const Name& name) {
+  const value_type* searched = elements.find(name);
+  if (searched == nullptr)
+    return ErrorCode::ItemNotFound;
+  if (observer != nullptr)
+    observer->onItemRemoved(searched->second);
+  elements.remove(name);
+  return ErrorCode::Ok;
+}
+template <PhysicalDerived T>
+bool Container<T>::find(T item) const {
+  return elements.find(item.getName()) != nullptr;
+}
+template <PhysicalDerived T>
+std::optional<T> Container<T>::find(const Name& name) const {
+  const value_type* searched = elements.find(name);
+  if (searched == nullptr)
+    return std::nullopt;
+  std::optional<T> item = searched->second;
+  item->setObserver(observer);
+  return item;
+}
+template <PhysicalDerived T>
+size_t Container<T>::size() const {
+  return elements.size();
+}
+template <PhysicalDerived T>
+typename Container<T>::const_iterator Container<T>::begin() const {
+  auto order = std::make_shared<std::vector<const value_type*>>();
+  order->reserve(elements.size());
+  elements.forEach([&order](const value_type& element) { order->push_back(&element); });
+  std::sort(order->begin(), order->end(), [](const value_type* a, const value_type* b) { return a->first < b->first; });
+  return const_iterator(std::move(order), 0);
+}
+template <PhysicalDerived T>
+typename Container<T>::const_iterator Container<T>::end() const {
+  return const_iterator(nullptr, elements.size());
+}
+
+template <PhysicalDerived T>
+class ContainerWithMaxCapacity : public Container<T> {
+ private:
+  int maxCapacity;
+
+ public:
+  explicit ContainerWithMaxCapacity(int);
+  int getMaxCapacity() const;
+  ErrorCode add(T) override;
+  void show(std::ofstream& out);
+};
+template <PhysicalDerived T>
+ContainerWithMaxCapacity<T>::ContainerWithMaxCapacity(int maxCapacity) : maxCapacity(maxCapacity) {}
+template <PhysicalDerived T>
+int ContainerWithMaxCapacity<T>::getMaxCapacity() const {
+  return maxCapacity;
+}
+template <PhysicalDerived T>
+void ContainerWithMaxCapacity<T>::show(std::ofstream& out) {
+  bool first = true;
+  for (const auto& [name, element] : *this) {
+    if (first) {
+      out << element;
+      first = false;
+    } else {
+      out << ' ' << element;
+    }
+  }
+  out << '\n';
+}
+template <PhysicalDerived T>
+ErrorCode ContainerWithMaxCapacity<T>::add(T item) {
+  if (Container<T>::elements.size() == static_cast<size_t>(maxCapacity))
+    return ErrorCode::ContainerFull;
+  return Container<T>::add(item);
+}
+
+extern template class Container<Weapon>;
+extern template class Container<Potion>;
+extern template class Container<Spell>;
+extern template class ContainerWithMaxCapacity<Weapon>;
+extern template class ContainerWithMaxCapacity<Potion>;
+extern template class ContainerWithMaxCapacity<Spell>;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// Counter values at one instant, or the difference between two instants.
+struct CounterSample {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cacheMisses = 0;
+  uint64_t branchMisses = 0;
+};
+
+// Cycles, instructions, cache misses and branch misses of the calling
+// thread, read as one perf_event group. Counters the kernel refuses are left
+// at zero. When not even the cycle counter opens (containers, VMs,
+// perf_event_paranoid), cycles come from rdtsc and the rest stay zero.
+class HardwareCounters {
+ private:
+  static constexpr size_t counterCount = 4;
+  int leader;
+  std::array<int, counterCount> descriptors;
+
+ public:
+  HardwareCounters();
+  HardwareCounters(const HardwareCounters&) = delete;
+  HardwareCounters& operator=(const HardwareCounters&) = delete;
+  ~HardwareCounters();
+  bool usesPerf() const;
+  bool has(size_t) const;
+  CounterSample read() const;
+};
+
+// What a sample is attributed to: the command that was dispatched, or the
+// item subclass whose useLogic ran. Command slots follow the Keyword order.
+enum class ProfileSlot : uint8_t {
+  Create,
+  Attack,
+  Cast,
+  Drink,
+  Dialogue,
+  Show,
+  Query,
+  Invalid,
+  WeaponUse,
+  PotionUse,
+  SpellUse,
+};
+inline constexpr size_t profileSlotCount = static_cast<size_t>(ProfileSlot::SpellUse) + 1;
+inline constexpr std::array<std::string_view, profileSlotCount> profileSlotNames = {
+    "Create", "Attack", "Cast", "Drink", "Dialogue", "Show", "Query", "(invalid)", "Weapon::useLogic",
+    "Potion::useLogic", "Spell::useLogic",
+};
+
+// Accumulates counter deltas per slot for the thread it is installed on.
+// Samples nest: a Cast command includes the Spell::useLogic sample it
+// triggered. With no profiler installed a ProfileScope costs one
+// thread-local load and a branch.
+class CycleProfiler {
+ private:
+  struct Totals {
+    uint64_t samples = 0;
+    CounterSample sum;
+  };
+  HardwareCounters counters;
+  std::array<Totals, profileSlotCount> totals;
+  CycleProfiler* previous;
+
+ public:
+  CycleProfiler();
+  CycleProfiler(const CycleProfiler&) = delete;
+  CycleProfiler& operator=(const CycleProfiler&) = delete;
+  ~CycleProfiler();
+  static CycleProfiler* active();
+  CounterSample read() const;
+  void add(ProfileSlot, const CounterSample&, const CounterSample&);
+  void report(std::ostream&) const;
+};
+
+class ProfileScope {
+ private:
+  CycleProfiler* profiler;
+  ProfileSlot slot;
+  CounterSample start;
+
+ public:
+  explicit ProfileScope(ProfileSlot);
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+  ~ProfileScope();
+};
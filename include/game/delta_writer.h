@@ -0,0 +1,34 @@
+#pragma once
+
+#include "game/error.h"
+#include "game/world.h"
+
+#include <istream>
+#include <ostream>
+
+// Differential output: one compact line per state change instead of full
+// dumps. Lines carry absolute values, so applyDeltas can rebuild a world
+// from them:
+//   C <name> <hp> <weapon-cap> <potion-cap> <spell-cap>   character added
+//   H <name> <hp>                                          HP changed
+//   + weapon|potion <owner> <item> <value>                 item added
+//   + spell <owner> <item> <target-count> <target>...
+//   - <weapon|potion|spell> <owner> <item>                 item removed
+//   U <weapon|potion|spell> <owner> <item>                 item consumed
+// Effect formulas are not written.
+class DeltaWriter : public WorldObserver {
+ private:
+  std::ostream& out;
+
+ public:
+  explicit DeltaWriter(std::ostream&);
+  void onCharacterAdded(const World&, uint32_t) override;
+  void onHealthChanged(const Character&, int) override;
+  void onItemAdded(const PhysicalItem&) override;
+  void onItemRemoved(const PhysicalItem&) override;
+  void onItemConsumed(const PhysicalItem&) override;
+};
+
+// Applies DeltaWriter lines to world, which must hold the state the writer
+// started from. Stops at the first line that does not apply.
+ErrorCode applyDeltas(std::istream&, World&);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Outcome of an engine operation. Routine failures such as a full container
+// or a missing item are reported with these codes rather than exceptions.
+enum class ErrorCode : uint8_t {
+  Ok,
+  ContainerFull,
+  ItemNotFound,
+  NotOwner,
+  ItemUsed,
+  InvalidTarget,
+  InvalidValue,
+  InvalidHandle,
+};
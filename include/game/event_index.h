@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Sidecar index for a text session log, where every non-empty line is one
+// event. Every interval-th event gets a checkpoint holding its byte offset
+// and the command sequence number the interpreter reaches there, so a
+// reader can start at the checkpoint and scan at most interval - 1 lines.
+// With snapshots, the world state at each checkpoint is saved next to the
+// index as <index>.<checkpoint>.snap.
+struct EventCheckpoint {
+  uint64_t event;
+  uint64_t offset;
+  uint64_t sequence;
+};
+struct EventIndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t interval;
+  uint64_t eventCount;
+  uint64_t logSize;
+  uint64_t checkpointCount;
+  uint32_t hasSnapshots;
+  uint32_t reserved;
+};
+constexpr char eventIndexMagic[8] = {'S', 'S', 'A', 'D', 'I', 'D', 'X', '1'};
+constexpr uint32_t eventIndexVersion = 1;
+
+class EventIndex {
+ private:
+  uint32_t interval;
+  uint64_t eventCount;
+  uint64_t logSize;
+  bool hasSnapshots;
+  std::vector<EventCheckpoint> checkpoints;
+
+ public:
+  EventIndex();
+  static EventIndex build(std::string_view, uint32_t, const std::string& = {});
+  static EventIndex read(std::istream&);
+  void write(std::ostream&) const;
+  uint32_t getInterval() const;
+  uint64_t getEventCount() const;
+  uint64_t getLogSize() const;
+  bool snapshotsSaved() const;
+  size_t checkpointOf(uint64_t) const;
+  const EventCheckpoint& checkpoint(size_t) const;
+  std::optional<uint64_t> offsetOf(std::string_view, uint64_t) const;
+};
+
+std::string checkpointSnapshotPath(const std::string&, size_t);
+
+// Prints the characters as they are just before the given event: restores
+// the nearest checkpoint snapshot (or starts from an empty world) and
+// replays the events in between. Returns false if the log no longer has the
+// indexed size or the snapshot cannot be restored.
+bool printStateAt(std::string_view, const EventIndex&, const std::string&, uint64_t, std::ostream&);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "game/random.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Designer-written effect expression compiled to register bytecode, e.g.
+// "base + target_hp / 10" or "max(5, roll(20) - 3)". Supports integer
+// + - * / (wrapping; division by zero yields 0), unary minus, parentheses,
+// the variables base, user_hp and target_hp, and min(a, b), max(a, b) and
+// roll(n), which is uniform in [1, n].
+//
+// Variables live in fixed registers and constant operands are folded or
+// carried as immediates, so "base" compiles to no instructions at all and
+// "base + roll(6)" to two.
+class Formula {
+ private:
+  enum class Op : uint8_t { Load, Neg, Roll, RollI, Add, Sub, Mul, Div, Min, Max, AddI, SubI, MulI, DivI, MinI, MaxI };
+  struct Instruction {
+    Op op;
+    uint8_t dst;
+    uint8_t a;
+    uint8_t b;
+    int64_t immediate;
+  };
+  static constexpr uint8_t baseRegister = 0;
+  static constexpr uint8_t userHPRegister = 1;
+  static constexpr uint8_t targetHPRegister = 2;
+  static constexpr uint8_t firstTemporary = 3;
+  std::vector<Instruction> code;
+  uint8_t result;
+  bool readsHP;
+  bool rollsDice;
+  std::string source;
+
+  static int64_t apply(Op, int64_t, int64_t);
+  static int64_t roll(int64_t, CombatRandom*);
+  int64_t execute(int64_t, int64_t, int64_t, CombatRandom*) const;
+  class Compiler;
+  Formula();
+
+ public:
+  static constexpr uint8_t maxRegisters = 16;
+  static std::optional<Formula> compile(std::string_view);
+  // Arguments are base, user_hp, target_hp and the generator roll() draws
+  // from; without a generator every roll returns its upper bound.
+  int64_t evaluate(int64_t, int64_t, int64_t, CombatRandom*) const;
+  size_t getInstructionCount() const;
+  const std::string& getSource() const;
+  // Whether user_hp or target_hp appears in the expression.
+  bool readsHealth() const;
+  // Whether roll() appears, i.e. whether evaluate() needs a generator.
+  bool rolls() const;
+};
+
+// Called once per use, so the checks that let a caller skip work stay
+// inline. A formula with no instructions is a bare variable and never
+// enters the interpreter loop.
+inline int64_t Formula::evaluate(int64_t base, int64_t userHP, int64_t targetHP, CombatRandom* random) const {
+  if (code.empty())
+    return result == baseRegister ? base : result == userHPRegister ? userHP : targetHP;
+  return execute(base, userHP, targetHP, random);
+}
+inline bool Formula::readsHealth() const {
+  return readsHP;
+}
+inline bool Formula::rolls() const {
+  return rollsDice;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "game/error.h"
+#include "game/world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Damage, heal value or number of allowed targets, depending on the item kind.
+// name points into the session and stays valid until the item is removed; it
+// is not NUL-terminated.
+struct InventoryEntry {
+  const char* name;
+  uint32_t nameLength;
+  int32_t value;
+};
+
+// In-process API for high-frequency callers. Storage for every character is
+// reserved up front, so handles never move, and no call throws: failures come
+// back as an ErrorCode. A session is not safe to share between threads.
+// Combat randomness for the n-th use() comes from stream n of the seed.
+class GameSession {
+ private:
+  World world;
+  size_t maxCharacters;
+  int containerCapacity;
+  uint64_t commandCount;
+
+  bool isValid(uint32_t) const;
+  template <PhysicalDerived T>
+  ContainerWithMaxCapacity<T>& containerOf(uint32_t);
+  template <PhysicalDerived T>
+  const ContainerWithMaxCapacity<T>& containerOf(uint32_t) const;
+  template <PhysicalDerived T>
+  ErrorCode useItem(uint32_t, uint32_t, std::string_view);
+  template <PhysicalDerived T>
+  ErrorCode setItemEffect(uint32_t, std::string_view, std::shared_ptr<const Formula>);
+  template <PhysicalDerived T>
+  size_t listItems(uint32_t, std::span<InventoryEntry>, size_t) const;
+
+ public:
+  GameSession(size_t, int, uint64_t = 1);
+  ErrorCode createCharacter(std::string_view, int, uint32_t&);
+  ErrorCode createWeapon(uint32_t, std::string_view, int);
+  ErrorCode createPotion(uint32_t, std::string_view, int);
+  ErrorCode createSpell(uint32_t, std::string_view, std::span<const uint32_t>);
+  ErrorCode setEffect(ItemKind, uint32_t, std::string_view, std::string_view);
+  ErrorCode use(ItemKind, uint32_t, uint32_t, std::string_view);
+  ErrorCode health(uint32_t, int&) const;
+  size_t inventory(uint32_t, ItemKind, std::span<InventoryEntry>, size_t = 0) const;
+  const World& getWorld() const;
+};
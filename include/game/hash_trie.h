@@ -0,0 +1,253 @@
+#pragma once
+
+#include "game/name.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+// Hash array mapped trie from item name to T. Copies of a trie share its
+// nodes, so copying is O(1). set and remove copy the nodes on the key's path
+// that another copy still holds and change the rest in place: an unshared
+// trie is updated without copying, and every other copy is left intact.
+template <typename T>
+class HashTrie {
+ private:
+  static constexpr size_t bits = 5;
+  static constexpr size_t hashBits = 64;
+  struct Node;
+  // An entry holds either an item or the child node for its hash slot.
+  struct Entry {
+    std::optional<std::pair<Name, T>> item;
+    std::shared_ptr<const Node> child;
+  };
+  // Below hashBits a node is a bitmap-compressed array of entries; at full
+  // depth it is a plain list of keys whose hashes collide completely. The
+  // entries follow the header in the same allocation, so reading a node
+  // costs one cache miss, and hold their name and item inline.
+  struct alignas(Entry) Node {
+    uint32_t bitmap = 0;
+    uint32_t size = 0;
+    uint32_t capacity = 0;
+
+    Entry* begin() { return std::launder(reinterpret_cast<Entry*>(this + 1)); }
+    Entry* end() { return begin() + size; }
+    const Entry* begin() const { return std::launder(reinterpret_cast<const Entry*>(this + 1)); }
+    const Entry* end() const { return begin() + size; }
+  };
+  std::shared_ptr<const Node> root;
+  size_t count = 0;
+
+  static uint64_t hashOf(const Name&);
+  static std::shared_ptr<const Node> allocate(uint32_t);
+  static Node& writable(std::shared_ptr<const Node>&, uint32_t);
+  static void insertAt(std::shared_ptr<const Node>&, uint32_t, Entry);
+  static void eraseAt(Node&, uint32_t);
+  static void insert(std::shared_ptr<const Node>&, size_t, uint64_t, Entry, bool&);
+  static void erase(std::shared_ptr<const Node>&, size_t, uint64_t, const Name&);
+  template <typename F>
+  static void forEach(const Node&, F&);
+
+ public:
+  void set(const Name&, T);
+  bool remove(const Name&);
+  const std::pair<Name, T>* find(const Name&) const;
+  size_t size() const;
+  template <typename F>
+  void forEach(F) const;
+};
+// Name::hash leaves names that differ only in their last bytes equal in the
+// low bits, which the trie consumes first, so they would share a chain of
+// single-entry nodes. The finalizer from MurmurHash3 spreads every input bit.
+template <typename T>
+uint64_t HashTrie<T>::hashOf(const Name& key) {
+  uint64_t hash = std::hash<Name>{}(key);
+  hash = (hash ^ hash >> 33) * 0xFF51AFD7ED558CCDull;
+  hash = (hash ^ hash >> 33) * 0xC4CEB9FE1A85EC53ull;
+  return hash ^ hash >> 33;
+}
+template <typename T>
+std::shared_ptr<const typename HashTrie<T>::Node> HashTrie<T>::allocate(uint32_t capacity) {
+  void* memory = ::operator new(sizeof(Node) + capacity * sizeof(Entry));
+  Node* node = new (memory) Node{0, 0, capacity};
+  return std::shared_ptr<const Node>(node, [](const Node* shared) {
+    Node* node = const_cast<Node*>(shared);
+    std::destroy(node->begin(), node->end());
+    node->~Node();
+    ::operator delete(node);
+  });
+}
+// Returns the node, replaced first by a copy if another trie still holds it
+// or by a larger one if it has no room for extra more entries. Nodes are
+// never created const, so an unshared one can be written through the const
+// pointer.
+template <typename T>
+typename HashTrie<T>::Node& HashTrie<T>::writable(std::shared_ptr<const Node>& node, uint32_t extra) {
+  if (!node) {
+    node = allocate(std::max<uint32_t>(extra, 1));
+    return const_cast<Node&>(*node);
+  }
+  bool unique = node.use_count() == 1;
+  if (unique && node->size + extra <= node->capacity)
+    return const_cast<Node&>(*node);
+  uint32_t capacity = node->size + extra;
+  if (unique)
+    capacity = std::max(capacity, node->capacity * 2);
+  std::shared_ptr<const Node> copy = allocate(capacity);
+  Node& target = const_cast<Node&>(*copy);
+  Node& source = const_cast<Node&>(*node);
+  target.bitmap = source.bitmap;
+  for (Entry& entry : source) {
+    if (unique)
+      new (target.end()) Entry(std::move(entry));
+    else
+      new (target.end()) Entry(entry);
+    ++target.size;
+  }
+  node = std::move(copy);
+  return target;
+}
+template <typename T>
+void HashTrie<T>::insertAt(std::shared_ptr<const Node>& node, uint32_t position, Entry entry) {
+  Node& target = writable(node, 1);
+  if (position == target.size) {
+    new (target.end()) Entry(std::move(entry));
+  } else {
+    new (target.end()) Entry(std::move(target.begin()[target.size - 1]));
+    std::move_backward(target.begin() + position, target.end() - 1, target.end());
+    target.begin()[position] = std::move(entry);
+  }
+  ++target.size;
+}
+template <typename T>
+void HashTrie<T>::eraseAt(Node& target, uint32_t position) {
+  std::move(target.begin() + position + 1, target.end(), target.begin() + position);
+  std::destroy_at(target.end() - 1);
+  --target.size;
+}
+template <typename T>
+void HashTrie<T>::insert(std::shared_ptr<const Node>& node, size_t shift, uint64_t hash, Entry entry, bool& added) {
+  if (shift >= hashBits) {
+    Node& target = writable(node, 0);
+    for (Entry& existing : target) {
+      if (existing.item->first == entry.item->first) {
+        existing = std::move(entry);
+        return;
+      }
+    }
+    insertAt(node, target.size, std::move(entry));
+    added = true;
+    return;
+  }
+  uint32_t bit = uint32_t{1} << ((hash >> shift) & 31);
+  uint32_t position = node ? std::popcount(node->bitmap & (bit - 1)) : 0;
+  if (!node || (node->bitmap & bit) == 0) {
+    insertAt(node, position, std::move(entry));
+    const_cast<Node&>(*node).bitmap |= bit;
+    added = true;
+    return;
+  }
+  Entry& slot = writable(node, 0).begin()[position];
+  if (slot.child) {
+    insert(slot.child, shift + bits, hash, std::move(entry), added);
+  } else if (slot.item->first == entry.item->first) {
+    slot = std::move(entry);
+  } else {
+    bool ignored = false;
+    uint64_t slotHash = hashOf(slot.item->first);
+    std::shared_ptr<const Node> child;
+    insert(child, shift + bits, slotHash, std::move(slot), ignored);
+    insert(child, shift + bits, hash, std::move(entry), added);
+    slot = Entry{std::nullopt, std::move(child)};
+  }
+}
+// The key must be present.
+template <typename T>
+void HashTrie<T>::erase(std::shared_ptr<const Node>& node, size_t shift, uint64_t hash, const Name& key) {
+  Node& target = writable(node, 0);
+  if (shift >= hashBits) {
+    for (uint32_t i = 0; i < target.size; ++i) {
+      if (target.begin()[i].item->first == key) {
+        eraseAt(target, i);
+        break;
+      }
+    }
+  } else {
+    uint32_t bit = uint32_t{1} << ((hash >> shift) & 31);
+    uint32_t position = std::popcount(target.bitmap & (bit - 1));
+    Entry& slot = target.begin()[position];
+    if (slot.child)
+      erase(slot.child, shift + bits, hash, key);
+    if (slot.child && slot.child->size == 1 && !slot.child->begin()->child) {
+      std::shared_ptr<const Node> child = std::move(slot.child);
+      slot.item = child->begin()->item;
+    } else if (!slot.child) {
+      target.bitmap &= ~bit;
+      eraseAt(target, position);
+    }
+  }
+  if (target.size == 0)
+    node = nullptr;
+}
+template <typename T>
+void HashTrie<T>::set(const Name& key, T value) {
+  bool added = false;
+  insert(root, 0, hashOf(key), Entry{std::pair<Name, T>(key, std::move(value)), nullptr}, added);
+  count += added ? 1 : 0;
+}
+template <typename T>
+bool HashTrie<T>::remove(const Name& key) {
+  if (find(key) == nullptr)
+    return false;
+  erase(root, 0, hashOf(key), key);
+  --count;
+  return true;
+}
+template <typename T>
+const std::pair<Name, T>* HashTrie<T>::find(const Name& key) const {
+  uint64_t hash = hashOf(key);
+  const Node* node = root.get();
+  for (size_t shift = 0; node != nullptr; shift += bits) {
+    if (shift >= hashBits) {
+      for (const Entry& entry : *node) {
+        if (entry.item->first == key)
+          return &*entry.item;
+      }
+      return nullptr;
+    }
+    uint32_t bit = uint32_t{1} << ((hash >> shift) & 31);
+    if ((node->bitmap & bit) == 0)
+      return nullptr;
+    const Entry& slot = node->begin()[std::popcount(node->bitmap & (bit - 1))];
+    if (!slot.child)
+      return slot.item->first == key ? &*slot.item : nullptr;
+    node = slot.child.get();
+  }
+  return nullptr;
+}
+template <typename T>
+size_t HashTrie<T>::size() const {
+  return count;
+}
+template <typename T>
+template <typename F>
+void HashTrie<T>::forEach(const Node& node, F& visit) {
+  for (const Entry& entry : node) {
+    if (entry.child)
+      forEach(*entry.child, visit);
+    else
+      visit(*entry.item);
+  }
+}
+template <typename T>
+template <typename F>
+void HashTrie<T>::forEach(F visit) const {
+  if (root)
+    forEach(*root, visit);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "game/character.h"
+#include "game/error.h"
+#include "game/formula.h"
+#include "game/item_catalog.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// An item instance is a pointer to its shared prototype, the interned name
+// of its owner and the per-instance state; all definition data lives in the
+// ItemCatalog.
+class PhysicalItem {
+ private:
+  const ItemPrototype* prototype;
+  const Name* ownerName;
+  ContainerObserver* observer;
+  bool isUsableOnce;
+  bool isUsed;
+
+ protected:
+  const ItemPrototype& getPrototype() const;
+  ErrorCode useCondition(const Character&, const Character&) const;
+  void giveDamageTo(Character&, int);
+  void giveHealTo(Character&, int);
+  void afterUse();
+  int effectValue(const Character&, const Character&, int) const;
+  virtual ErrorCode useLogic(const Character&, Character&) = 0;
+  virtual std::ostream& print(std::ostream&) const = 0;
+  friend std::ostream& operator<<(std::ostream&, const PhysicalItem&);
+
+ public:
+  PhysicalItem();
+  PhysicalItem(const Character&, const ItemPrototype*, bool = false);
+  virtual ~PhysicalItem() = default;
+  ErrorCode use(const Character&, Character&);
+  const Name& getName() const;
+  const Name& getOwnerName() const;
+  bool wasUsed() const;
+  void setUsed(bool);
+  const Formula* getEffect() const;
+  void setObserver(ContainerObserver*);
+  void setEffect(std::shared_ptr<const Formula>);
+  virtual ErrorCode setup() const = 0;
+};
+
+class Weapon : public PhysicalItem {
+ private:
+  virtual ErrorCode useLogic(const Character&, Character&) override;
+
+ public:
+  Weapon(const Character&, const Name&, int);
+  Weapon(const Character&, const ItemPrototype*);
+  int getDamage() const;
+  ErrorCode setup() const override;
+  std::ostream& print(std::ostream&) const override;
+  friend std::ostream& operator<<(std::ostream& out, const Weapon& weapon);
+};
+
+class Potion : public PhysicalItem {
+ private:
+  virtual ErrorCode useLogic(const Character&, Character&) override;
+
+ public:
+  Potion(const Character&, const Name&, int);
+  Potion(const Character&, const ItemPrototype*);
+  int getHealValue() const;
+  ErrorCode setup() const override;
+  std::ostream& print(std::ostream&) const override;
+  friend std::ostream& operator<<(std::ostream& out, const Potion& potion);
+};
+
+class Spell : public PhysicalItem {
+ private:
+  ErrorCode useLogic(const Character&, Character&) override;
+
+ public:
+  Spell(const Character&, const Name&, const std::vector<Character>&);
+  Spell(const Character&, const ItemPrototype*);
+  size_t getNumAllowedTargets() const;
+  const std::vector<Name>& getAllowedTargets() const;
+  ErrorCode setup() const override;
+  std::ostream& print(std::ostream&) const override;
+  friend std::ostream& operator<<(std::ostream& out, const Spell& spell);
+};
+
+// Times Weapon::use, with the per-command seek in front of it, for the fixed
+// damage and for each effect formula in the README table. Each row is the
+// best of five runs of the given number of uses.
+void benchmarkEffects(size_t, std::ostream&);
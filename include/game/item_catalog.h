@@ -0,0 +1,56 @@
+#pragma once
+
+#include "game/formula.h"
+#include "game/name.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Definition data shared by every instance of one kind of item: the name,
+// the damage or heal value, the names a spell may target and the effect
+// formula. Prototypes are immutable once interned.
+struct ItemPrototype {
+  Name name;
+  int value;
+  std::vector<Name> allowedTargets;
+  std::shared_ptr<const Formula> effect;
+
+  bool operator==(const ItemPrototype&) const;
+};
+
+// Append-only intern table for prototypes and owner names. Entries are
+// never freed, so the pointers it hands out stay valid for the life of the
+// process and can be shared freely between sessions and threads.
+class ItemCatalog {
+ private:
+  struct Hash {
+    using is_transparent = void;
+    size_t operator()(const ItemPrototype*) const;
+    size_t operator()(const Name*) const;
+    size_t operator()(const Name&) const;
+  };
+  struct Equal {
+    using is_transparent = void;
+    bool operator()(const ItemPrototype*, const ItemPrototype*) const;
+    bool operator()(const Name*, const Name*) const;
+    bool operator()(const Name*, const Name&) const;
+    bool operator()(const Name&, const Name*) const;
+  };
+  mutable std::mutex mutex;
+  std::deque<ItemPrototype> prototypes;
+  std::deque<Name> names;
+  std::unordered_set<const ItemPrototype*, Hash, Equal> prototypeIndex;
+  std::unordered_set<const Name*, Hash, Equal> nameIndex;
+
+ public:
+  static ItemCatalog& shared();
+  const ItemPrototype* intern(const ItemPrototype&);
+  const Name* internName(const Name&);
+  size_t size() const;
+};
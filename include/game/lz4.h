@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// LZ4 block and frame codec for session archives, following the published
+// LZ4 format, so files interoperate with the lz4 tool. The writer emits
+// independent 4 MiB blocks. Independent blocks can be decompressed in any
+// order, which is what lets the reader spread them across threads.
+namespace lz4 {
+
+inline constexpr uint32_t frameMagic = 0x184D2204;
+inline constexpr size_t maxBlockSize = size_t{4} << 20;
+inline constexpr size_t frameHeaderSize = 7;
+inline constexpr size_t frameEndSize = 4;
+
+uint32_t xxh32(const void*, size_t, uint32_t = 0);
+size_t compressBound(size_t);
+size_t compressBlock(const char*, size_t, char*);
+std::optional<size_t> decompressBlock(const char*, size_t, char*, size_t);
+
+struct Block {
+  const char* data;
+  uint32_t size;
+  bool compressed;
+};
+bool isFrame(std::string_view);
+// Walks the block headers of every frame in the data without decompressing
+// anything. Throws on a malformed frame or one with linked blocks.
+std::vector<Block> frameBlocks(std::string_view);
+void writeFrameHeader(std::ostream&);
+size_t writeBlock(std::ostream&, const char*, size_t, std::string&);
+void writeFrameEnd(std::ostream&);
+
+}  // namespace lz4
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Character and item name stored inline: up to 31 bytes, zero-padded, and
+// the length in the last byte, 32 bytes in all. Copies never allocate, and
+// equality and hashing work on whole 16-byte halves instead of walking
+// characters. Because the padding is zero, comparing the raw bytes orders
+// names exactly as std::string would.
+class Name {
+ public:
+  static constexpr size_t capacity = 31;
+
+ private:
+  char bytes[capacity];
+  uint8_t length;
+
+ public:
+  Name();
+  explicit Name(std::string_view);
+  explicit Name(const std::string&);
+  explicit Name(const char*);
+  static bool fits(std::string_view);
+  const char* data() const;
+  size_t size() const;
+  bool empty() const;
+  std::string_view view() const;
+  std::string str() const;
+  size_t hash() const;
+  friend bool operator==(const Name&, const Name&);
+  friend std::strong_ordering operator<=>(const Name&, const Name&);
+  friend std::ostream& operator<<(std::ostream&, const Name&);
+};
+static_assert(sizeof(Name) == 32 && std::is_trivially_copyable_v<Name>);
+
+inline Name::Name() : bytes(), length(0) {}
+// Longer input is cut at capacity; callers that accept names from outside
+// check fits() first. The constructors are explicit so that a truncating
+// conversion is always visible at the call site.
+inline Name::Name(std::string_view text) : bytes(), length(static_cast<uint8_t>(std::min(text.size(), capacity))) {
+  std::memcpy(bytes, text.data(), length);
+}
+inline Name::Name(const std::string& text) : Name(std::string_view(text)) {}
+inline Name::Name(const char* text) : Name(std::string_view(text)) {}
+inline bool Name::fits(std::string_view text) {
+  return text.size() <= capacity;
+}
+inline const char* Name::data() const {
+  return bytes;
+}
+inline size_t Name::size() const {
+  return length;
+}
+inline bool Name::empty() const {
+  return length == 0;
+}
+inline std::string_view Name::view() const {
+  return {bytes, length};
+}
+inline std::string Name::str() const {
+  return std::string(view());
+}
+inline size_t Name::hash() const {
+  uint64_t words[4];
+  std::memcpy(words, this, sizeof(words));
+  uint64_t low = (words[0] ^ words[2]) * 0x9E3779B97F4A7C15ull;
+  uint64_t high = (words[1] ^ words[3]) * 0xC2B2AE3D27D4EB4Full;
+  uint64_t mixed = low ^ (high >> 29 | high << 35);
+  return static_cast<size_t>(mixed ^ mixed >> 32);
+}
+inline bool operator==(const Name& a, const Name& b) {
+#if defined(__SSE2__)
+  const auto* left = reinterpret_cast<const __m128i*>(&a);
+  const auto* right = reinterpret_cast<const __m128i*>(&b);
+  __m128i equal = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(left), _mm_loadu_si128(right)),
+                                _mm_cmpeq_epi8(_mm_loadu_si128(left + 1), _mm_loadu_si128(right + 1)));
+  return _mm_movemask_epi8(equal) == 0xFFFF;
+#else
+  return std::memcmp(&a, &b, sizeof(Name)) == 0;
+#endif
+}
+inline std::strong_ordering operator<=>(const Name& a, const Name& b) {
+  return std::memcmp(a.bytes, b.bytes, Name::capacity) <=> 0;
+}
+inline std::ostream& operator<<(std::ostream& out, const Name& name) {
+  return out.write(name.bytes, static_cast<std::streamsize>(name.length));
+}
+
+template <>
+struct std::hash<Name> {
+  size_t operator()(const Name& name) const { return name.hash(); }
+};
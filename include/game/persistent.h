@@ -0,0 +1,96 @@
+#pragma once
+
+#include "game/error.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Fixed-size vector as a 32-way trie of shared, immutable nodes. Copying the
+// vector is O(1) and set() copies only the O(log32 n) nodes on the path to
+// the changed element, its leaf of values included, so copies share
+// everything they have not modified. set() past the end returns InvalidHandle and changes nothing.
+template <typename T>
+class PersistentVector {
+ private:
+  static constexpr size_t bits = 5;
+  static constexpr size_t width = size_t{1} << bits;
+  // Nodes at shift 0 are leaves holding up to width values inline; every
+  // other node is an inner node. The depth says which one a node is.
+  struct Node {};
+  struct Leaf : Node {
+    std::vector<T> values;
+  };
+  struct Inner : Node {
+    std::array<std::shared_ptr<const Node>, width> children;
+  };
+  std::shared_ptr<const Node> root;
+  size_t count;
+  size_t rootShift;
+
+  std::shared_ptr<const Node> set(const std::shared_ptr<const Node>&, size_t, size_t, T);
+
+ public:
+  explicit PersistentVector(const std::vector<T>& = {});
+  size_t size() const;
+  const T& operator[](size_t) const;
+  ErrorCode set(size_t, T);
+};
+// Builds the leaves from consecutive runs of values, then each level of
+// inner nodes from the one below, instead of copying a path per element.
+template <typename T>
+PersistentVector<T>::PersistentVector(const std::vector<T>& values) : root(), count(values.size()), rootShift(0) {
+  while ((width << rootShift) < count)
+    rootShift += bits;
+  std::vector<std::shared_ptr<const Node>> level;
+  for (size_t begin = 0; begin < count; begin += width) {
+    auto leaf = std::make_shared<Leaf>();
+    leaf->values.assign(values.begin() + begin, values.begin() + std::min(begin + width, count));
+    level.push_back(std::move(leaf));
+  }
+  for (size_t shift = bits; shift <= rootShift; shift += bits) {
+    std::vector<std::shared_ptr<const Node>> parents;
+    for (size_t begin = 0; begin < level.size(); begin += width) {
+      auto inner = std::make_shared<Inner>();
+      for (size_t i = begin; i < std::min(begin + width, level.size()); ++i)
+        inner->children[i - begin] = std::move(level[i]);
+      parents.push_back(std::move(inner));
+    }
+    level = std::move(parents);
+  }
+  if (!level.empty())
+    root = std::move(level.front());
+}
+template <typename T>
+size_t PersistentVector<T>::size() const {
+  return count;
+}
+template <typename T>
+const T& PersistentVector<T>::operator[](size_t index) const {
+  const Node* node = root.get();
+  for (size_t shift = rootShift; shift > 0; shift -= bits)
+    node = static_cast<const Inner*>(node)->children[(index >> shift) & (width - 1)].get();
+  return static_cast<const Leaf*>(node)->values[index & (width - 1)];
+}
+template <typename T>
+std::shared_ptr<const typename PersistentVector<T>::Node> PersistentVector<T>::set(
+    const std::shared_ptr<const Node>& node, size_t shift, size_t index, T value) {
+  size_t slot = (index >> shift) & (width - 1);
+  if (shift == 0) {
+    auto copy = std::make_shared<Leaf>(static_cast<const Leaf&>(*node));
+    copy->values[slot] = std::move(value);
+    return copy;
+  }
+  auto copy = std::make_shared<Inner>(static_cast<const Inner&>(*node));
+  copy->children[slot] = set(copy->children[slot], shift - bits, index, std::move(value));
+  return copy;
+}
+template <typename T>
+ErrorCode PersistentVector<T>::set(size_t index, T value) {
+  if (index >= count)
+    return ErrorCode::InvalidHandle;
+  root = set(root, rootShift, index, std::move(value));
+  return ErrorCode::Ok;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+
+// Counter-based Philox4x32-10 generator. Output depends only on the seed,
+// the stream and how many values were drawn, never on which thread or shard
+// draws them, so a session keyed per event replays identically whether it
+// runs in one process or many. next() produces one four-value block at a
+// time, since a command usually draws only a few values after its seek;
+// fill() produces a batch of blocks per pass, a loop with no cross-block
+// dependencies that the compiler can vectorize.
+class CombatRandom {
+ public:
+  static constexpr size_t blocksPerBatch = 16;
+
+ private:
+  std::array<uint32_t, 2> key;
+  uint64_t stream;
+  uint64_t block;
+  std::array<uint32_t, 4 * blocksPerBatch> buffer;
+  size_t position;
+  size_t filled;
+
+  void refillBlock();
+  void refillBatch();
+
+ public:
+  explicit CombatRandom(uint64_t = 1, uint64_t = 0);
+  void seek(uint64_t, uint64_t);
+  uint32_t next();
+  uint32_t below(uint32_t);
+  bool chance(uint32_t);
+  void fill(std::span<uint32_t>);
+};
+
+// The calling thread's generator. Callers position it with seek() before
+// each command so draws are keyed by session seed and command sequence.
+CombatRandom& threadRandom();
+
+// Times next(), fill() and std::mt19937 per value, with a seek every
+// valuesPerSeek values as the per-command pattern does.
+void benchmarkRandom(size_t, size_t, std::ostream&);
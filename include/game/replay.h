@@ -0,0 +1,60 @@
+#pragma once
+
+#include "game/session.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+// Output sink that compares everything written to it against a golden
+// stream one chunk at a time with memcmp, and remembers the first byte
+// where the two differ. Nothing is kept beyond the current chunk.
+class GoldenComparator : public std::streambuf {
+ private:
+  std::istream& golden;
+  std::vector<char> actual;
+  std::vector<char> expected;
+  uint64_t flushed;
+  uint64_t compared;
+  uint64_t matchedLines;
+  std::optional<uint64_t> divergence;
+
+  void compareChunk();
+
+ protected:
+  int_type overflow(int_type) override;
+
+ public:
+  GoldenComparator(std::istream&, size_t);
+  uint64_t written() const;
+  uint64_t getCompared() const;
+  bool diverged() const;
+  bool finish();
+  std::optional<uint64_t> getDivergence() const;
+  uint64_t getMatchedLines() const;
+};
+
+struct ReplayReport {
+  bool matches;
+  uint64_t byteOffset;
+  uint64_t line;
+  std::optional<size_t> eventIndex;
+};
+
+// Runs events on a copy of initial and streams the output through a
+// GoldenComparator, stopping at the first difference. On a mismatch the
+// session is replayed up to the divergent event to describe it: the golden
+// and actual text, and the user and target with their items before and
+// after it.
+ReplayReport verifyReplay(const World&, const std::vector<SessionEvent>&, std::istream&, std::ostream&,
+                          size_t = size_t{1} << 20);
+// The same check for a command file, plain or LZ4-compressed, run from an
+// empty world through the parser runCommandInput uses. eventIndex is the
+// zero-based line whose output differs; the report shows that command with
+// its expected and actual output.
+ReplayReport verifyCommandReplay(std::string_view, std::istream&, std::ostream&, size_t = size_t{1} << 20);
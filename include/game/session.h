@@ -0,0 +1,41 @@
+#pragma once
+
+#include "game/world.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One item use: the user applies their item, looked up by name in the
+// container of the given kind, to the target.
+struct SessionEvent {
+  uint64_t sequence;
+  ItemKind kind;
+  uint32_t user;
+  uint32_t target;
+  std::string item;
+};
+
+// How far a session has run: the ticks completed and the sequence number the
+// next event takes. With the world, whose seed fixes every roll, it is all a
+// run needs to continue from a checkpoint.
+struct SessionPosition {
+  uint64_t tick = 0;
+  uint64_t nextSequence = 0;
+};
+
+template <PhysicalDerived T>
+void writeUse(std::ostream&, const Character&, const Character&, const std::string&);
+void runEvent(World&, const SessionEvent&, std::ostream&);
+void runSession(World&, const std::vector<SessionEvent>&, std::ostream&);
+
+// Reproducible synthetic workload for benchmarks and PGO training: every
+// character gets a few weapons, potions and spells, and events pick a random
+// user, target and item kind. missingPercent of the events name an item the
+// user does not have.
+struct SyntheticSession {
+  World world;
+  std::vector<SessionEvent> events;
+};
+SyntheticSession generateSession(uint32_t, size_t, uint64_t = 1, uint32_t = 10);
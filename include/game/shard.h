@@ -0,0 +1,79 @@
+#pragma once
+
+#include "game/delta_writer.h"
+#include "game/session.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+// Sharded simulation: characters (and the containers they own) are spread
+// over worker processes by handle hash, and each worker holds only its own
+// shard, sent to it as a snapshot at startup. A use runs on the user's
+// shard, which validates and consumes the item against a stand-in for the
+// target and replies with the HP change. The coordinator keeps world, its
+// copy of the whole state, current from those replies: it prints each use
+// in event order, applies the change to world and queues it for the
+// target's shard, which receives it with its next batch.
+//
+// A worker never sees HP held by another shard, so worlds whose weapon or
+// potion formulas read user_hp or target_hp, or whose spells have a formula
+// (a spell's base is the target's HP), are refused; everything else prints
+// the same output as runSession.
+
+void sendBatch(int, const std::string&);
+std::optional<std::string> receiveBatch(int);
+size_t shardOf(uint32_t, size_t);
+
+// Attached to world as an observer, the coordinator also queues characters
+// and items added there (e.g. by Create commands) for the shard that owns
+// them. Other changes made to world directly are not forwarded.
+class ShardCoordinator : public WorldObserver {
+ private:
+  World& world;
+  std::vector<int> sockets;
+  std::vector<pid_t> workers;
+  std::vector<std::string> outgoing;
+  std::unordered_map<Name, uint32_t> handles;
+  std::ostringstream added;
+  DeltaWriter addedWriter;
+
+  std::string shardSnapshot(size_t) const;
+  void queueAdded(uint32_t);
+  template <PhysicalDerived T>
+  void applyUse(ContainerWithMaxCapacity<T>&, const SessionEvent&, std::string_view, std::ostream&);
+  std::vector<std::string> exchange();
+  void stop();
+
+ public:
+  static bool supports(const World&);
+  ShardCoordinator(World&, size_t);
+  ShardCoordinator(const ShardCoordinator&) = delete;
+  ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+  ~ShardCoordinator() override;
+  void run(const std::vector<SessionEvent>&, std::ostream&, size_t = 4096);
+  // The state one worker holds, after the effects queued for it.
+  World shard(size_t);
+
+  void onCharacterAdded(const World&, uint32_t) override;
+  void onHealthChanged(const Character&, int) override;
+  void onItemAdded(const PhysicalItem&) override;
+  void onItemRemoved(const PhysicalItem&) override;
+  void onItemConsumed(const PhysicalItem&) override;
+};
+
+// Runs command text with item uses spread over shards worker processes.
+// The text is parsed window by window (forEachCommandBatch). Consecutive
+// uses go to the shards in batches; any other command first waits for them
+// and then runs on world, which the coordinator keeps current, so the
+// workers keep running through Show, Query and Create. Worlds that
+// ShardCoordinator refuses run serially.
+void runShardedCommands(std::string_view, World&, std::ostream&, size_t);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "game/session.h"
+#include "game/world.h"
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Snapshot file layout: a header followed by flat record arrays and a string
+// pool. Every reference is an offset or an index, so a mapped file is usable
+// in place without any fix-up pass. Effects are stored as formula source
+// and compiled again on restore. The header also carries the session
+// position the world was saved at, so a checkpoint can be resumed.
+struct SnapshotString {
+  uint32_t offset;
+  uint32_t length;
+};
+struct CharacterRecord {
+  int32_t healthPoints;
+  SnapshotString name;
+};
+struct ContainerRecord {
+  uint32_t owner;
+  ItemKind kind;
+  int32_t maxCapacity;
+  uint32_t firstItem;
+  uint32_t itemCount;
+};
+struct ItemRecord {
+  SnapshotString name;
+  int32_t value;
+  uint32_t firstTarget;
+  uint32_t targetCount;
+  SnapshotString effect;
+  uint32_t used;
+};
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t characterCount;
+  uint32_t containerCount;
+  uint32_t itemCount;
+  uint32_t targetCount;
+  uint32_t reserved;
+  uint64_t characterOffset;
+  uint64_t containerOffset;
+  uint64_t itemOffset;
+  uint64_t targetOffset;
+  uint64_t stringOffset;
+  uint64_t stringSize;
+  uint64_t randomSeed;
+  uint64_t tick;
+  uint64_t nextSequence;
+};
+constexpr char snapshotMagic[8] = {'S', 'S', 'A', 'D', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshotVersion = 3;
+
+class SnapshotWriter {
+ private:
+  std::vector<CharacterRecord> characters;
+  std::vector<ContainerRecord> containers;
+  std::vector<ItemRecord> items;
+  std::vector<CharacterRecord> targets;
+  std::string strings;
+  uint64_t randomSeed;
+  SessionPosition position;
+
+  SnapshotString intern(std::string_view);
+  CharacterRecord record(const Character&);
+  template <PhysicalDerived T>
+  void addContainer(uint32_t, ItemKind, const ContainerWithMaxCapacity<T>&);
+
+ public:
+  explicit SnapshotWriter(const World&, SessionPosition = {});
+  void write(std::ostream&) const;
+};
+
+// Read-only access to a snapshot in place. The constructor checks every
+// section, index and string against the buffer and throws if anything
+// points outside it, so the accessors and restore() never read out of
+// bounds. Queries can run on the view directly. Simulating needs a World,
+// and restore() builds one by copying every record into live characters and
+// containers, in time linear in the snapshot.
+class SnapshotView {
+ private:
+  const char* data;
+  size_t length;
+  const SnapshotHeader* header;
+
+  template <typename Record>
+  std::span<const Record> section(uint64_t, uint32_t) const;
+  template <typename Record>
+  bool holds(uint64_t, uint32_t) const;
+  bool holds(SnapshotString) const;
+  bool isValid() const;
+
+ public:
+  SnapshotView(const char*, size_t);
+  std::span<const CharacterRecord> characters() const;
+  std::span<const ContainerRecord> containers() const;
+  std::span<const ItemRecord> items(const ContainerRecord&) const;
+  std::span<const CharacterRecord> targets(const ItemRecord&) const;
+  std::string_view string(SnapshotString) const;
+  uint64_t randomSeed() const;
+  SessionPosition position() const;
+  Character character(const CharacterRecord&) const;
+  World restore() const;
+};
+
+class MappedSnapshot {
+ private:
+  void* address;
+  size_t length;
+
+ public:
+  explicit MappedSnapshot(const std::string&);
+  MappedSnapshot(const MappedSnapshot&) = delete;
+  MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+  ~MappedSnapshot();
+  SnapshotView view() const;
+};
+
+// Returns false if the file could not be created or written in full.
+bool saveSnapshot(const World&, const std::string&, SessionPosition = {});
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "game/async_checkpoint.h"
+#include "game/session.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Tick durations in nanoseconds, kept raw so any percentile can be reported.
+class LatencyRecorder {
+ private:
+  std::vector<uint64_t> samples;
+
+ public:
+  explicit LatencyRecorder(size_t = 0);
+  void record(std::chrono::nanoseconds);
+  size_t size() const;
+  std::chrono::nanoseconds percentile(double) const;
+};
+
+// Server mode: commands are queued from any thread and executed once per
+// tick against the world, and each tick's output is flushed as one write.
+// Every tick's processing time is recorded and compared with the budget.
+// With checkpoints enabled, every interval-th tick ends by forking a
+// snapshot writer; the tick pays only for the fork. The loop tracks its
+// session position, which each checkpoint records and resumeAt() restores.
+class TickLoop {
+ private:
+  World& world;
+  std::ostream& out;
+  std::chrono::nanoseconds budget;
+  std::mutex queueMutex;
+  std::vector<SessionEvent> pending;
+  std::vector<SessionEvent> running;
+  std::string buffer;
+  LatencyRecorder latencies;
+  size_t overruns;
+  SessionPosition position;
+  AsyncCheckpointer checkpointer;
+  size_t checkpointInterval;
+  std::string checkpointPath;
+  LatencyRecorder checkpointPauses;
+  LatencyRecorder checkpointDurations;
+  uint64_t copiedPages;
+  size_t skippedCheckpoints;
+  size_t failedCheckpoints;
+
+  void recordCheckpoint();
+
+ public:
+  TickLoop(World&, std::ostream&, std::chrono::nanoseconds);
+  void checkpointEvery(size_t, std::string);
+  void finishCheckpoints();
+  void resumeAt(SessionPosition);
+  SessionPosition getPosition() const;
+  void enqueue(SessionEvent);
+  std::chrono::nanoseconds tick();
+  void run(size_t, std::chrono::nanoseconds, const std::function<void(size_t)>& = {});
+  const LatencyRecorder& getLatencies() const;
+  size_t getOverruns() const;
+  void report(std::ostream&) const;
+};
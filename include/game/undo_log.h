@@ -0,0 +1,60 @@
+#pragma once
+
+#include "game/world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Undo/redo over game commands on a world. Every command records the
+// primitive changes it made into a fixed-size ring; undo replays their
+// inverses and redo replays them forward, so a step costs the same whatever
+// the world size. Entries name characters by handle and look characters and
+// containers up in the world when applied, so they stay valid when the
+// world's vectors grow. Commands return InvalidHandle for handles outside
+// the world. When the ring is full the oldest whole command is forgotten.
+// Like a command log, every use() takes the next command number, starting
+// from the given first sequence, and rolls from that stream of the world's
+// seed; undo does not give numbers back, and redo reapplies recorded
+// changes without rolling again.
+class UndoLog {
+ private:
+  // An entry changes either the health of character by delta or, when item
+  // holds one, the contents of character's container of that kind.
+  struct Entry {
+    uint64_t command;
+    bool added;
+    uint32_t character;
+    int delta;
+    std::variant<std::monostate, Weapon, Potion, Spell> item;
+  };
+  World& world;
+  std::vector<Entry> ring;
+  size_t first;
+  size_t cursor;
+  size_t last;
+  uint64_t nextCommand;
+  uint64_t nextSequence;
+
+  size_t wrap(size_t) const;
+  void record(Entry);
+  void apply(const Entry&, bool);
+  template <PhysicalDerived T>
+  ContainerWithMaxCapacity<T>& container(uint32_t);
+  static void changeHealth(Character&, int);
+
+ public:
+  explicit UndoLog(World&, size_t = 4096, uint64_t = 0);
+  ErrorCode takeDamage(uint32_t, int);
+  ErrorCode heal(uint32_t, int);
+  template <PhysicalDerived T>
+  ErrorCode add(uint32_t, T);
+  template <PhysicalDerived T>
+  ErrorCode remove(uint32_t, const std::string&);
+  template <PhysicalDerived T>
+  ErrorCode use(uint32_t, uint32_t, const std::string&);
+  bool undo();
+  bool redo();
+};
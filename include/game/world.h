@@ -0,0 +1,33 @@
+#pragma once
+
+#include "game/container.h"
+
+#include <cstdint>
+#include <vector>
+
+enum class ItemKind : uint32_t { Weapon, Potion, Spell };
+
+// Character i owns arsenals[i], medicalBags[i] and spellBooks[i]. Combat
+// randomness for a command is drawn from stream <sequence> under randomSeed.
+struct World {
+  uint64_t randomSeed = 1;
+  std::vector<Character> characters;
+  std::vector<ContainerWithMaxCapacity<Weapon>> arsenals;
+  std::vector<ContainerWithMaxCapacity<Potion>> medicalBags;
+  std::vector<ContainerWithMaxCapacity<Spell>> spellBooks;
+};
+
+void observeWorld(World&, WorldObserver*);
+
+class WorldObservers : public WorldObserver {
+ private:
+  std::vector<WorldObserver*> observers;
+
+ public:
+  void add(WorldObserver*);
+  void onCharacterAdded(const World&, uint32_t) override;
+  void onHealthChanged(const Character&, int) override;
+  void onItemAdded(const PhysicalItem&) override;
+  void onItemRemoved(const PhysicalItem&) override;
+  void onItemConsumed(const PhysicalItem&) override;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "game/persistent.h"
+#include "game/world.h"
+
+#include <cstdint>
+#include <string>
+
+// Copy-on-write view of a World for what-if branches. fork() is O(1); each
+// branch copies only the characters and containers it actually changes, and
+// a container copy shares its item trie, so changing one item copies only
+// the trie nodes on that item's path.
+// Setters and use() return InvalidHandle for handles outside the world.
+// Every use() call takes the next command number, starting from the given
+// first sequence, and rolls from that stream of the world's seed, so a fork
+// that repeats a command log's uses rolls what the log did. Forks continue
+// the numbering of the branch they were taken from.
+class WorldFork {
+ private:
+  uint64_t randomSeed;
+  uint64_t nextSequence;
+  PersistentVector<Character> characters;
+  PersistentVector<ContainerWithMaxCapacity<Weapon>> arsenals;
+  PersistentVector<ContainerWithMaxCapacity<Potion>> medicalBags;
+  PersistentVector<ContainerWithMaxCapacity<Spell>> spellBooks;
+
+  template <PhysicalDerived T, typename Self>
+  static auto& containers(Self&);
+
+ public:
+  explicit WorldFork(const World&, uint64_t = 0);
+  WorldFork fork() const;
+  size_t size() const;
+  const Character& character(uint32_t) const;
+  ErrorCode setCharacter(uint32_t, const Character&);
+  template <PhysicalDerived T>
+  const ContainerWithMaxCapacity<T>& container(uint32_t) const;
+  template <PhysicalDerived T>
+  ErrorCode setContainer(uint32_t, const ContainerWithMaxCapacity<T>&);
+  template <PhysicalDerived T>
+  ErrorCode use(uint32_t, uint32_t, const std::string&);
+  World materialize() const;
+};
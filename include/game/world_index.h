@@ -0,0 +1,36 @@
+#pragma once
+
+#include "game/error.h"
+#include "game/world.h"
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Secondary indexes over a World: characters ordered by HP and, for every
+// item name, the characters holding such an item. Characters are kept by
+// handle, so the index stays valid when the world's vectors reallocate.
+class WorldIndex : public WorldObserver {
+ private:
+  const World& world;
+  std::set<std::pair<int, uint32_t>> byHealth;
+  std::map<Name, std::multiset<Name>> ownersByItem;
+
+ public:
+  explicit WorldIndex(const World&);
+  WorldIndex(const WorldIndex&) = delete;
+  WorldIndex& operator=(const WorldIndex&) = delete;
+  void onCharacterAdded(const World&, uint32_t) override;
+  void onHealthChanged(const Character&, int) override;
+  void onItemAdded(const PhysicalItem&) override;
+  void onItemRemoved(const PhysicalItem&) override;
+  void onItemConsumed(const PhysicalItem&) override;
+  std::vector<const Character*> charactersWithHP(int, int) const;
+  std::vector<Name> ownersOf(const Name&) const;
+  ErrorCode query(std::span<const std::string_view>, std::ostream&) const;
+};
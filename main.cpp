@@ -1,193 +1,337 @@
-#include <concepts>
+#include "game/alloc_profile.h"
+#include "game/command.h"
+#include "game/command_file.h"
+#include "game/compressed_output.h"
+#include "game/cycle_profiler.h"
+#include "game/delta_writer.h"
+#include "game/event_index.h"
+#include "game/lz4.h"
+#include "game/replay.h"
+#include "game/session.h"
+#include "game/shard.h"
+#include "game/snapshot.h"
+#include "game/tick_loop.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <map>
-#include <ostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
-#include <vector>
-
-class Character;
-class PhysicalItem;
-class Weapon;
-class Potion;
-class Spell;
-
-template <typename CurClass>
-concept PhysicalDerived = std::is_base_of<CurClass, PhysicalItem>::value;
-
-class Character {
- private:
-  int healthPoints;
-  std::string name;
-
- protected:
-  void obtainItemSideEffect(const PhysicalItem&);
-  void loseItemSideEffect(const PhysicalItem&);
-  friend std::ostream& operator<<(std::ostream& out, const Character&);
-
- public:
-  int getHP() const;
-  std::string getName() const;
-  void takeDamage(int);
-  void heal(int);
-};
-int Character::getHP() const {
-  return healthPoints;
-}
-std::string Character::getName() const {
-  return name;
-}
-void Character::takeDamage(int damage) {
-  healthPoints -= damage;
-}
-void Character::heal(int healVolume) {
-  healthPoints += healVolume;
-}
-
-class PhysicalItem {
- private:
-  bool isUsableOnce;
-  Character owner;
-  std::string name;
-
- protected:
-  Character getOwner;
-  void useCondition(const Character&, const Character&);
-  void giveDamageTo(Character&, int);
-  void giveHealTo(Character&, int);
-  void afterUse();
-  virtual void useLogic(const Character&, const Character&) = 0;
-  friend std::ostream& operator<<(std::ostream&, const PhysicalItem&);
-
- public:
-  PhysicalItem();
-  PhysicalItem(const Character&, const std::string&);
-  void use(const Character&, const Character&);
-  std::string getName() const;
-  virtual void setup() = 0;
-};
-PhysicalItem::PhysicalItem() : isUsableOnce(false), owner(), name(nullptr) {}
-PhysicalItem::PhysicalItem(const Character& ch, const std::string& name) : isUsableOnce(false), owner(ch), name(name) {}
-std::string PhysicalItem::getName() const {
-  return name;
-}
-void PhysicalItem::giveDamageTo(Character &target, int damage) {
-  target.takeDamage(damage);
-}
-void PhysicalItem::giveHealTo(Character &target, int healVolume) {
-  target.heal(healVolume);
-}
-
-class Weapon : public PhysicalItem {
- private:
-  int damage;
-  virtual void useLogic(const Character&, const Character&) override;
-
- public:
-  int getDamage();
-  void setup() override;
-  friend std::ostream& operator<<(std::ostream& out, const Weapon& weapon);
-};
-int Weapon::getDamage() {
-  return damage;
-}
-std::ostream& operator<<(std::ostream& out, const Weapon& weapon) {
-    out << weapon.getName() << ":" << weapon.damage;
-};
-
-class Potion : public PhysicalItem {
- private:
-  int healValue;
-  virtual void useLogic(const Character&, const Character&) override;
-
- public:
-  int getHealValue();
-  void setup() override;
-};
-int Potion::getHealValue() {
-  return healValue;
-}
+#include <string_view>
+#include <system_error>
 
-class Spell : public PhysicalItem {
- private:
-  std::vector<Character> allowedTargets;
-  void useLogic(const Character&, const Character&) override;
+namespace {
 
- public:
-  size_t getNumAllowedTargets();
-  void setup() override;
-};
-size_t Spell::getNumAllowedTargets() {
-  return allowedTargets.size();
-}
+constexpr const char* usageText =
+    "Usage: assignment_2_ssad --synthetic <characters> <events> [seed] [missing-percent]\n"
+    "       assignment_2_ssad --tick <characters> <events-per-tick> <ticks> [tick-hz] [budget-us]\n"
+    "                         [checkpoint-every-ticks checkpoint-file]\n"
+    "       assignment_2_ssad --record|--verify <golden-file> <characters> <events> [seed] [missing-percent]\n"
+    "       assignment_2_ssad --record|--verify <golden-file> --commands <commands-file>\n"
+    "       assignment_2_ssad --run <commands-file> [--profile] [--out <file> [--lz4]] [--delta <file> | --shards <n>]\n"
+    "       assignment_2_ssad --index <commands-file> <index-file> [interval] [--snapshots]\n"
+    "       assignment_2_ssad --seek <commands-file> <index-file> <event> [count]\n"
+    "       assignment_2_ssad --state-at <commands-file> <index-file> <event>\n"
+    "       assignment_2_ssad --compress <file> <lz4-file>\n"
+    "       assignment_2_ssad --keyword-bench [lookups]\n"
+    "       assignment_2_ssad --effect-bench [uses]\n"
+    "       assignment_2_ssad --random-bench [values] [values-per-seek]\n";
 
-template <PhysicalDerived T>
-class Container {
- protected:
-  std::map<std::string, T> elements;
- public:
-  virtual void add(T);
-  void remove(T) = 0;
-  void remove(std::string) = 0;
-  bool find(T) = 0;
-  T find(std::string) = 0;
-};
-template <PhysicalDerived T>
-void Container<T>::add(T item) {
-  std::string itemName = item.getName();
-  elements[itemName] = item;
-}
-template <PhysicalDerived T>
-void Container<T>::remove(T item) {
-  if (elements.size() == 0 || !find(item))
-    throw std::runtime_error("Error caught");
-  elements.erase(item.getName());
-}
-template <PhysicalDerived T>
-void Container<T>::remove(std::string name) {
-  if (elements.size() == 0 || !find(name))
-    throw std::runtime_error("Error caught");
-  elements.erase(name);
+int usage() {
+  std::cerr << usageText;
+  return 2;
 }
-template <PhysicalDerived T>
-bool Container<T>::find(T item) {
-  return elements.contains(item.getName());
-}
-template <PhysicalDerived T>
-T Container<T>::find(std::string name) {
-  if (auto searched = elements.find(name); searched != elements.end())
-    return searched->second;
-  return NULL;
+// The whole argument must be a number that fits value's type; signs on
+// unsigned types, trailing text and overflow are all rejected.
+template <typename T>
+bool parseNumber(const char* text, T& value) {
+  std::string_view digits(text);
+  auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+  return error == std::errc() && end == digits.data() + digits.size();
 }
 
-template <PhysicalDerived T>
-class ContainerWithMaxCapacity : public Container<T> {
- private:
-  int maxCapacity;
+}  // namespace
 
- public:
-  void add(T) override;
-  void show(std::ofstream& out);
-};
-template <PhysicalDerived T>
-void ContainerWithMaxCapacity<T>::show(std::ofstream& out) {
-  bool first = true;
-  for (T element : Container<T>::elements) {
-    if (first) {
-      out << element;
-      first = false;
-    } else {
-      out << ' ' << element;
+int main(int argc, char** argv) {
+  if (allocationProfilingEnabled())
+    std::atexit([] { reportAllocations(std::cerr); });
+  if (argc >= 3 && std::string(argv[1]) == "--run") {
+    std::optional<MappedFile> file;
+    try {
+      file.emplace(argv[2]);
+    } catch (const std::runtime_error&) {
+      std::cerr << "Cannot open " << argv[2] << '\n';
+      return 2;
+    }
+    std::optional<CycleProfiler> profiler;
+    std::optional<std::ofstream> outputFile;
+    std::optional<std::ofstream> deltaFile;
+    size_t shards = 0;
+    bool compressOutput = false;
+    for (int i = 3; i < argc; ++i) {
+      std::string option = argv[i];
+      if (option == "--profile")
+        profiler.emplace();
+      else if (option == "--out" && i + 1 < argc)
+        outputFile.emplace(argv[++i], std::ios::binary);
+      else if (option == "--lz4")
+        compressOutput = true;
+      else if (option == "--delta" && i + 1 < argc)
+        deltaFile.emplace(argv[++i], std::ios::binary);
+      else if (option == "--shards" && i + 1 < argc && !parseNumber(argv[++i], shards))
+        return usage();
+    }
+    if (shards > 0 && (deltaFile || lz4::isFrame(file->text()))) {
+      std::cerr << "--shards runs uncompressed command files without --delta\n";
+      return 2;
     }
+    std::ostream& plain = outputFile ? *outputFile : std::cout;
+    std::optional<CompressingStreamBuffer> compressor;
+    std::optional<std::ostream> compressed;
+    if (compressOutput) {
+      compressor.emplace(plain);
+      compressed.emplace(&*compressor);
+    }
+    World world;
+    if (shards > 0) {
+      try {
+        runShardedCommands(file->text(), world, compressed ? *compressed : plain, shards);
+      } catch (const std::runtime_error&) {
+        std::cerr << "Shard workers failed\n";
+        return 1;
+      }
+      if (compressor)
+        compressor->finish();
+      if (profiler)
+        profiler->report(std::cerr);
+      return plain ? 0 : 1;
+    }
+    CommandInterpreter interpreter(world, compressed ? *compressed : plain);
+    std::optional<DeltaWriter> deltas;
+    if (deltaFile) {
+      deltas.emplace(*deltaFile);
+      interpreter.setObserver(&*deltas);
+    }
+    try {
+      runCommandInput(file->text(), interpreter);
+    } catch (const std::runtime_error&) {
+      std::cerr << "Corrupt archive " << argv[2] << '\n';
+      return 1;
+    }
+    if (compressor)
+      compressor->finish();
+    if (profiler)
+      profiler->report(std::cerr);
+    if (deltaFile)
+      deltaFile->flush();
+    return plain && (!deltaFile || *deltaFile) ? 0 : 1;
   }
-  out << '\n';
-}
-template <PhysicalDerived T>
-void ContainerWithMaxCapacity<T>::add(T item) {
-  if (Container<T>::elements.size() == maxCapacity)
-    throw std::runtime_error("Error caught");
-  Container<T>::add(item);
+  if (argc >= 4 && (std::string(argv[1]) == "--index" || std::string(argv[1]) == "--seek" ||
+                    std::string(argv[1]) == "--state-at")) {
+    std::string mode = argv[1];
+    std::optional<MappedFile> file;
+    try {
+      file.emplace(argv[2]);
+    } catch (const std::runtime_error&) {
+      std::cerr << "Cannot open " << argv[2] << '\n';
+      return 2;
+    }
+    std::string_view log = file->text();
+    if (mode == "--index") {
+      uint32_t interval = 100000;
+      if (argc >= 5 && !parseNumber(argv[4], interval))
+        return usage();
+      bool snapshots = argc >= 6 && std::string(argv[5]) == "--snapshots";
+      EventIndex index;
+      try {
+        index = EventIndex::build(log, interval, snapshots ? argv[3] : "");
+      } catch (const std::runtime_error&) {
+        std::cerr << "Cannot write the snapshots for " << argv[3] << '\n';
+        return 1;
+      }
+      std::ofstream out(argv[3], std::ios::binary);
+      index.write(out);
+      return out ? 0 : 1;
+    }
+    std::ifstream in(argv[3], std::ios::binary);
+    EventIndex index;
+    try {
+      index = EventIndex::read(in);
+    } catch (const std::runtime_error&) {
+      std::cerr << "Cannot read index " << argv[3] << '\n';
+      return 2;
+    }
+    uint64_t event = 0;
+    uint64_t count = 1;
+    if ((argc >= 5 && !parseNumber(argv[4], event)) || (mode == "--seek" && argc >= 6 && !parseNumber(argv[5], count)))
+      return usage();
+    if (mode == "--state-at") {
+      if (printStateAt(log, index, argv[3], event, std::cout))
+        return 0;
+      std::cerr << "Cannot restore the state at event " << event << " from " << argv[3] << '\n';
+      return 1;
+    }
+    std::optional<uint64_t> offset = index.offsetOf(log, event);
+    if (!offset)
+      return 1;
+    std::string_view rest = log.substr(*offset);
+    while (count > 0 && !rest.empty()) {
+      std::string_view line = rest.substr(0, rest.find('\n'));
+      rest.remove_prefix(std::min(rest.size(), line.size() + 1));
+      if (line.find_first_not_of(" \t\r") == std::string_view::npos)
+        continue;
+      std::cout << line << '\n';
+      --count;
+    }
+    return 0;
+  }
+  if (argc >= 4 && std::string(argv[1]) == "--compress") {
+    std::optional<MappedFile> file;
+    try {
+      file.emplace(argv[2]);
+    } catch (const std::runtime_error&) {
+      std::cerr << "Cannot open " << argv[2] << '\n';
+      return 2;
+    }
+    std::string_view text = file->text();
+    std::ofstream out(argv[3], std::ios::binary);
+    std::string scratch;
+    lz4::writeFrameHeader(out);
+    for (size_t offset = 0; offset < text.size(); offset += lz4::maxBlockSize)
+      lz4::writeBlock(out, text.data() + offset, std::min(lz4::maxBlockSize, text.size() - offset), scratch);
+    lz4::writeFrameEnd(out);
+    return out ? 0 : 1;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "--keyword-bench") {
+    size_t lookups = 100000000;
+    if (argc >= 3 && !parseNumber(argv[2], lookups))
+      return usage();
+    benchmarkKeywords(lookups, std::cout);
+    return 0;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "--effect-bench") {
+    size_t uses = 10000000;
+    if (argc >= 3 && !parseNumber(argv[2], uses))
+      return usage();
+    benchmarkEffects(uses, std::cout);
+    return 0;
+  }
+  if (argc >= 2 && std::string(argv[1]) == "--random-bench") {
+    size_t values = 100000000;
+    size_t valuesPerSeek = 64;
+    if ((argc >= 3 && !parseNumber(argv[2], values)) || (argc >= 4 && !parseNumber(argv[3], valuesPerSeek)))
+      return usage();
+    benchmarkRandom(values, valuesPerSeek, std::cout);
+    return 0;
+  }
+  if (argc >= 5 && (std::string(argv[1]) == "--record" || std::string(argv[1]) == "--verify") &&
+      std::string(argv[3]) == "--commands") {
+    std::optional<MappedFile> file;
+    try {
+      file.emplace(argv[4]);
+    } catch (const std::runtime_error&) {
+      std::cerr << "Cannot open " << argv[4] << '\n';
+      return 2;
+    }
+    if (std::string(argv[1]) == "--record") {
+      std::ofstream golden(argv[2], std::ios::binary);
+      World world;
+      CommandInterpreter interpreter(world, golden);
+      runCommandInput(file->text(), interpreter);
+      return golden ? 0 : 1;
+    }
+    std::ifstream golden(argv[2], std::ios::binary);
+    if (!golden) {
+      std::cerr << "Cannot open " << argv[2] << '\n';
+      return 2;
+    }
+    return verifyCommandReplay(file->text(), golden, std::cout).matches ? 0 : 1;
+  }
+  if (argc >= 5 && (std::string(argv[1]) == "--record" || std::string(argv[1]) == "--verify")) {
+    uint32_t characters = 0;
+    size_t events = 0;
+    uint64_t seed = 1;
+    uint32_t missingPercent = 10;
+    if (!parseNumber(argv[3], characters) || !parseNumber(argv[4], events) ||
+        (argc >= 6 && !parseNumber(argv[5], seed)) || (argc >= 7 && !parseNumber(argv[6], missingPercent)))
+      return usage();
+    SyntheticSession session = generateSession(characters, events, seed, missingPercent);
+    if (std::string(argv[1]) == "--record") {
+      std::ofstream golden(argv[2], std::ios::binary);
+      runSession(session.world, session.events, golden);
+      return golden ? 0 : 1;
+    }
+    std::ifstream golden(argv[2], std::ios::binary);
+    if (!golden) {
+      std::cerr << "Cannot open " << argv[2] << '\n';
+      return 2;
+    }
+    return verifyReplay(session.world, session.events, golden, std::cout).matches ? 0 : 1;
+  }
+  if (argc >= 5 && std::string(argv[1]) == "--tick") {
+    uint32_t characters = 0;
+    size_t eventsPerTick = 0;
+    size_t ticks = 0;
+    double rate = 60.0;
+    int64_t budgetMicroseconds = 1000;
+    size_t checkpointInterval = 0;
+    if (!parseNumber(argv[2], characters) || !parseNumber(argv[3], eventsPerTick) || !parseNumber(argv[4], ticks) ||
+        (argc >= 6 && (!parseNumber(argv[5], rate) || !(rate > 0))) ||
+        (argc >= 7 && (!parseNumber(argv[6], budgetMicroseconds) || budgetMicroseconds < 0)) ||
+        (argc >= 9 && !parseNumber(argv[7], checkpointInterval)) ||
+        (eventsPerTick > 0 && ticks > SIZE_MAX / eventsPerTick))
+      return usage();
+    auto budget = std::chrono::microseconds(budgetMicroseconds);
+    SyntheticSession session = generateSession(characters, eventsPerTick * ticks);
+    std::ofstream sink("/dev/null");
+    TickLoop loop(session.world, sink, budget);
+    if (argc >= 9)
+      loop.checkpointEvery(checkpointInterval, argv[8]);
+    auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(1.0 / rate));
+    loop.run(ticks, period, [&](size_t tick) {
+      for (size_t i = 0; i < eventsPerTick; ++i)
+        loop.enqueue(std::move(session.events[tick * eventsPerTick + i]));
+    });
+    loop.finishCheckpoints();
+    loop.report(std::cout);
+    if (argc >= 9) {
+      // Timed on a file of its own, so the checkpoint file keeps the last
+      // checkpoint the loop wrote.
+      std::string timing = std::string(argv[8]).append(".timing");
+      auto start = std::chrono::steady_clock::now();
+      bool written = saveSnapshot(session.world, timing, loop.getPosition());
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      std::remove(timing.c_str());
+      if (!written) {
+        std::cerr << "Cannot write " << timing << '\n';
+        return 1;
+      }
+      std::cout << "a blocking snapshot of the same world takes " << elapsed.count() << " ms\n";
+    }
+    return 0;
+  }
+  if (argc >= 4 && std::string(argv[1]) == "--synthetic") {
+    uint32_t characters = 0;
+    size_t events = 0;
+    uint64_t seed = 1;
+    uint32_t missingPercent = 10;
+    if (!parseNumber(argv[2], characters) || !parseNumber(argv[3], events) ||
+        (argc >= 5 && !parseNumber(argv[4], seed)) || (argc >= 6 && !parseNumber(argv[5], missingPercent)))
+      return usage();
+    SyntheticSession session = generateSession(characters, events, seed, missingPercent);
+    std::ostringstream out;
+    auto start = std::chrono::steady_clock::now();
+    runSession(session.world, session.events, out);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << session.events.size() << " events in " << elapsed.count() << " s ("
+              << session.events.size() / elapsed.count() << " events/s), " << out.str().size() << " bytes of output\n";
+    return 0;
+  }
+  return usage();
 }
-
-int main() {
-}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "game/alloc_profile.h"
+
+#if defined(GAME_ALLOC_PROFILE)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+namespace {
+
+// Open-addressed table keyed by tag address. It is fixed-size and lock-free
+// because it is updated from inside operator new, where nothing may
+// allocate. Tags that find no free slot are counted under the last one.
+struct Site {
+  std::atomic<const char*> tag{nullptr};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> largest{0};
+};
+constexpr size_t siteCount = 256;
+std::array<Site, siteCount> sites;
+constexpr const char* untagged = "(untagged)";
+constexpr const char* overflow = "(other tags)";
+thread_local const char* currentTag = nullptr;
+
+Site& siteOf(const char* tag) {
+  size_t start = (reinterpret_cast<uintptr_t>(tag) >> 3) * 0x9E3779B97F4A7C15ull >> 56;
+  for (size_t probe = 0; probe < siteCount - 1; ++probe) {
+    Site& site = sites[(start + probe) % (siteCount - 1)];
+    const char* owner = site.tag.load(std::memory_order_acquire);
+    if (owner == tag)
+      return site;
+    if (owner == nullptr && site.tag.compare_exchange_strong(owner, tag, std::memory_order_acq_rel))
+      return site;
+    if (owner == tag)
+      return site;
+  }
+  Site& last = sites[siteCount - 1];
+  const char* none = nullptr;
+  last.tag.compare_exchange_strong(none, overflow, std::memory_order_acq_rel);
+  return last;
+}
+void record(size_t size) {
+  Site& site = siteOf(currentTag != nullptr ? currentTag : untagged);
+  site.allocations.fetch_add(1, std::memory_order_relaxed);
+  site.bytes.fetch_add(size, std::memory_order_relaxed);
+  uint64_t largest = site.largest.load(std::memory_order_relaxed);
+  while (size > largest && !site.largest.compare_exchange_weak(largest, size, std::memory_order_relaxed)) {
+  }
+}
+void* allocate(size_t size) {
+  record(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  if (void* memory = allocate(size))
+    return memory;
+  throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+  return ::operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory) noexcept {
+  std::free(memory);
+}
+void operator delete(void* memory, size_t) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+
+AllocationTag::AllocationTag(const char* tag) : previous(currentTag) {
+  currentTag = tag;
+}
+AllocationTag::~AllocationTag() {
+  currentTag = previous;
+}
+
+bool allocationProfilingEnabled() {
+  return true;
+}
+// Sites are copied out before sorting, so the report's own allocations land
+// in the table only after it has been read.
+void reportAllocations(std::ostream& report) {
+  struct Row {
+    const char* tag;
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t largest;
+  };
+  std::array<Row, siteCount> rows;
+  size_t used = 0;
+  for (const Site& site : sites)
+    if (const char* tag = site.tag.load(std::memory_order_acquire))
+      rows[used++] = {tag, site.allocations.load(std::memory_order_relaxed),
+                      site.bytes.load(std::memory_order_relaxed), site.largest.load(std::memory_order_relaxed)};
+  std::sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(used),
+            [](const Row& a, const Row& b) { return a.bytes > b.bytes; });
+  report << std::left << std::setw(28) << "tag" << std::right << std::setw(14) << "allocations" << std::setw(16)
+         << "bytes" << std::setw(10) << "avg" << std::setw(10) << "largest" << '\n';
+  for (size_t i = 0; i < used; ++i) {
+    const Row& row = rows[i];
+    report << std::left << std::setw(28) << row.tag << std::right << std::setw(14) << row.allocations
+           << std::setw(16) << row.bytes << std::setw(10) << (row.allocations == 0 ? 0 : row.bytes / row.allocations)
+           << std::setw(10) << row.largest << '\n';
+  }
+}
+
+#else
+
+bool allocationProfilingEnabled() {
+  return false;
+}
+void reportAllocations(std::ostream&) {}
+
+#endif
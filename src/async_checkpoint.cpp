@@ -0,0 +1,78 @@
+#include "game/async_checkpoint.h"
+#include "game/snapshot.h"
+
+#include <cstdio>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t minorFaults() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<uint64_t>(usage.ru_minflt);
+}
+
+}  // namespace
+
+AsyncCheckpointer::AsyncCheckpointer() : child(-1), faultsAtStart(0), completed(0) {}
+AsyncCheckpointer::~AsyncCheckpointer() {
+  wait();
+}
+// The child leaves with _exit so it runs none of the parent's exit handlers
+// or stream flushes.
+bool AsyncCheckpointer::start(const World& world, const std::string& path, SessionPosition position) {
+  if (child > 0)
+    return false;
+  faultsAtStart = minorFaults();
+  started = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0)
+    return false;
+  if (pid == 0) {
+    std::string temporary = path + ".tmp";
+    bool written =
+        saveSnapshot(world, temporary, position) && std::rename(temporary.c_str(), path.c_str()) == 0;
+    _exit(written ? 0 : 1);
+  }
+  child = pid;
+  current = CheckpointStats();
+  current.pause = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+  return true;
+}
+bool AsyncCheckpointer::running() const {
+  return child > 0;
+}
+void AsyncCheckpointer::collect(int status) {
+  current.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+  current.copiedPages = minorFaults() - faultsAtStart;
+  current.succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  last = current;
+  ++completed;
+  child = -1;
+}
+// Returns true when a checkpoint finished since the last call.
+bool AsyncCheckpointer::poll() {
+  if (child <= 0)
+    return false;
+  int status = 0;
+  if (waitpid(child, &status, WNOHANG) != child)
+    return false;
+  collect(status);
+  return true;
+}
+void AsyncCheckpointer::wait() {
+  if (child <= 0)
+    return;
+  int status = -1;
+  waitpid(child, &status, 0);
+  collect(status);
+}
+uint64_t AsyncCheckpointer::getCompleted() const {
+  return completed;
+}
+const CheckpointStats& AsyncCheckpointer::getLast() const {
+  return last;
+}
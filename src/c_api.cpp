@@ -0,0 +1,99 @@
+#include "game/c_api.h"
+#include "game/game_session.h"
+
+#include <algorithm>
+#include <array>
+#include <new>
+#include <stdexcept>
+
+struct game_session {
+  GameSession session;
+};
+
+static_assert(static_cast<int>(ErrorCode::InvalidHandle) == GAME_INVALID_HANDLE);
+static_assert(static_cast<int>(ItemKind::Spell) == GAME_SPELL);
+
+namespace {
+
+// No exception may cross into C. Allocation failures, including requests
+// too large to express (length_error), become GAME_OUT_OF_MEMORY; anything
+// else is reported as an invalid value.
+template <typename F>
+game_error guarded(F&& call) {
+  try {
+    return static_cast<game_error>(call());
+  } catch (const std::bad_alloc&) {
+    return GAME_OUT_OF_MEMORY;
+  } catch (const std::length_error&) {
+    return GAME_OUT_OF_MEMORY;
+  } catch (...) {
+    return GAME_INVALID_VALUE;
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+// The constructor reserves room for max_characters, which may throw.
+game_session* game_session_create(uint32_t max_characters, int32_t container_capacity) {
+  try {
+    return new game_session{GameSession(max_characters, container_capacity)};
+  } catch (...) {
+    return nullptr;
+  }
+}
+void game_session_destroy(game_session* session) {
+  delete session;
+}
+game_error game_create_character(game_session* session, const char* name, int32_t health_points, uint32_t* handle) {
+  return guarded([&] { return session->session.createCharacter(name, health_points, *handle); });
+}
+game_error game_create_weapon(game_session* session, uint32_t owner, const char* name, int32_t damage) {
+  return guarded([&] { return session->session.createWeapon(owner, name, damage); });
+}
+game_error game_create_potion(game_session* session, uint32_t owner, const char* name, int32_t heal_value) {
+  return guarded([&] { return session->session.createPotion(owner, name, heal_value); });
+}
+game_error game_create_spell(game_session* session, uint32_t owner, const char* name, const uint32_t* targets,
+                             uint32_t target_count) {
+  return guarded([&] { return session->session.createSpell(owner, name, {targets, target_count}); });
+}
+game_error game_set_effect(game_session* session, game_item_kind kind, uint32_t owner, const char* item,
+                           const char* formula) {
+  return guarded([&] { return session->session.setEffect(static_cast<ItemKind>(kind), owner, item, formula); });
+}
+game_error game_use(game_session* session, game_item_kind kind, uint32_t user, uint32_t target, const char* item) {
+  return guarded([&] { return session->session.use(static_cast<ItemKind>(kind), user, target, item); });
+}
+game_error game_health(const game_session* session, uint32_t handle, int32_t* health_points) {
+  return guarded([&] {
+    int value = 0;
+    ErrorCode error = session->session.health(handle, value);
+    *health_points = value;
+    return error;
+  });
+}
+// Copies field by field through a stack buffer, a chunk at a time, so the C
+// struct's layout is free to differ from InventoryEntry.
+uint32_t game_inventory(const game_session* session, uint32_t handle, game_item_kind kind,
+                        game_inventory_entry* entries, uint32_t capacity) {
+  std::array<InventoryEntry, 64> buffer;
+  try {
+    size_t total = 0;
+    uint32_t written = 0;
+    do {
+      uint32_t chunk = std::min<uint32_t>(capacity - written, buffer.size());
+      total = session->session.inventory(handle, static_cast<ItemKind>(kind), {buffer.data(), chunk}, written);
+      chunk = static_cast<uint32_t>(std::min<size_t>(chunk, total > written ? total - written : 0));
+      for (uint32_t i = 0; i < chunk; ++i)
+        entries[written + i] = {buffer[i].name, buffer[i].nameLength, buffer[i].value};
+      written += chunk;
+    } while (written < capacity && written < total);
+    return static_cast<uint32_t>(total);
+  } catch (...) {
+    return 0;
+  }
+}
+
+}
@@ -0,0 +1,38 @@
+#include "game/character.h"
+
+Character::Character() : healthPoints(0), name(), observer(nullptr) {}
+Character::Character(const Name& name, int healthPoints)
+    : healthPoints(healthPoints), name(name), observer(nullptr) {}
+// Copies never inherit the observer: an index tracks one particular object.
+Character::Character(const Character& other)
+    : healthPoints(other.healthPoints), name(other.name), observer(nullptr) {}
+Character& Character::operator=(const Character& other) {
+  int oldHP = healthPoints;
+  healthPoints = other.healthPoints;
+  name = other.name;
+  if (observer != nullptr && oldHP != healthPoints)
+    observer->onHealthChanged(*this, oldHP);
+  return *this;
+}
+void Character::setObserver(CharacterObserver* characterObserver) {
+  observer = characterObserver;
+}
+int Character::getHP() const {
+  return healthPoints;
+}
+const Name& Character::getName() const {
+  return name;
+}
+void Character::takeDamage(int damage) {
+  healthPoints -= damage;
+  if (observer != nullptr)
+    observer->onHealthChanged(*this, healthPoints + damage);
+}
+void Character::heal(int healVolume) {
+  healthPoints += healVolume;
+  if (observer != nullptr)
+    observer->onHealthChanged(*this, healthPoints - healVolume);
+}
+std::ostream& operator<<(std::ostream& out, const Character& character) {
+  return out << character.name << ":" << character.healthPoints;
+}
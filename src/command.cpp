@@ -0,0 +1,407 @@
+#include "game/command.h"
+#include "game/alloc_profile.h"
+#include "game/cycle_profiler.h"
+#include "game/session.h"
+
+#include <charconv>
+#include <chrono>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool isSeparator(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+bool nextNumber(TokenCursor& tokens, int& value) {
+  std::string_view token = tokens.next();
+  auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+  return !token.empty() && error == std::errc() && end == token.data() + token.size();
+}
+struct Capacities {
+  int weapons;
+  int potions;
+  int spells;
+};
+template <PhysicalDerived T>
+void showItems(std::ostream& out, const ContainerWithMaxCapacity<T>& container) {
+  bool first = true;
+  for (const auto& [name, item] : container) {
+    out << (first ? "" : " ") << item;
+    first = false;
+  }
+  out << '\n';
+}
+// Validates the item the way GameSession does before adding it, so a weapon
+// or potion worth nothing is refused instead of stored.
+template <PhysicalDerived T>
+ErrorCode addChecked(ContainerWithMaxCapacity<T>& container, T item) {
+  if (ErrorCode error = item.setup(); error != ErrorCode::Ok)
+    return error;
+  return container.add(std::move(item));
+}
+
+}  // namespace
+
+Keyword keywordByComparison(std::string_view word) {
+  if (word == "Create")
+    return Keyword::Create;
+  else if (word == "Attack")
+    return Keyword::Attack;
+  else if (word == "Cast")
+    return Keyword::Cast;
+  else if (word == "Drink")
+    return Keyword::Drink;
+  else if (word == "Dialogue")
+    return Keyword::Dialogue;
+  else if (word == "Show")
+    return Keyword::Show;
+  else if (word == "Query")
+    return Keyword::Query;
+  else if (word == "character")
+    return Keyword::Character;
+  else if (word == "item")
+    return Keyword::Item;
+  else if (word == "weapon")
+    return Keyword::Weapon;
+  else if (word == "potion")
+    return Keyword::Potion;
+  else if (word == "spell")
+    return Keyword::Spell;
+  else if (word == "fighter")
+    return Keyword::Fighter;
+  else if (word == "archer")
+    return Keyword::Archer;
+  else if (word == "wizard")
+    return Keyword::Wizard;
+  else if (word == "characters")
+    return Keyword::Characters;
+  else if (word == "weapons")
+    return Keyword::Weapons;
+  else if (word == "potions")
+    return Keyword::Potions;
+  else if (word == "spells")
+    return Keyword::Spells;
+  return Keyword::Unknown;
+}
+// Words are drawn with the command mix of a typical session: mostly item
+// uses, some creation and dialogue, and a few words outside the set.
+void benchmarkKeywords(size_t iterations, std::ostream& report) {
+  constexpr std::string_view words[] = {"Attack", "Cast",   "Drink", "Attack", "Drink", "Create", "Dialogue",
+                                        "Show",   "weapon", "spell", "potion", "item",  "Narrator", "attack"};
+  constexpr size_t sampleSize = 4096;
+  std::vector<std::string_view> sample;
+  std::mt19937_64 random(1);
+  for (size_t i = 0; i < sampleSize; ++i)
+    sample.push_back(words[random() % std::size(words)]);
+  auto measure = [&](Keyword (*lookup)(std::string_view)) {
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+      checksum += static_cast<uint64_t>(lookup(sample[i % sampleSize]));
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return std::pair(elapsed.count() / static_cast<double>(iterations), checksum);
+  };
+  auto [chain, chainChecksum] = measure(keywordByComparison);
+  auto [hashed, hashedChecksum] = measure([](std::string_view word) { return keywordOf(word); });
+  report << "if/else chain: " << chain << " ns/lookup\nperfect hash:  " << hashed << " ns/lookup\n";
+  if (chainChecksum != hashedChecksum)
+    report << "lookups disagree\n";
+}
+
+// Splits on the same separators as the classic reader: spaces, tabs and
+// carriage returns, with lines ending at '\n'. Blank lines produce no record.
+void parseCommands(std::string_view text, CommandBatch& batch) {
+  batch.text = text;
+  batch.records.clear();
+  batch.tokens.clear();
+  size_t position = 0;
+  while (position < text.size()) {
+    size_t lineEnd = text.find('\n', position);
+    if (lineEnd == std::string_view::npos)
+      lineEnd = text.size();
+    size_t first = batch.tokens.size();
+    for (size_t i = position; i < lineEnd;) {
+      if (isSeparator(text[i])) {
+        ++i;
+        continue;
+      }
+      size_t start = i;
+      while (i < lineEnd && !isSeparator(text[i]))
+        ++i;
+      batch.tokens.push_back({static_cast<uint32_t>(start), static_cast<uint32_t>(i - start)});
+    }
+    if (batch.tokens.size() > first) {
+      const TokenRef& command = batch.tokens[first];
+      batch.records.push_back({keywordOf(text.substr(command.offset, command.length)),
+                               static_cast<uint32_t>(first + 1), static_cast<uint32_t>(batch.tokens.size() - first - 1)});
+    }
+    position = lineEnd + 1;
+  }
+}
+
+TokenCursor::TokenCursor(std::string_view text, const TokenRef* position, const TokenRef* end)
+    : text(text), position(position), end(end) {}
+std::string_view TokenCursor::next() {
+  if (position == end)
+    return {};
+  const TokenRef& token = *position++;
+  return text.substr(token.offset, token.length);
+}
+bool TokenCursor::atEnd() const {
+  return position == end;
+}
+
+CommandInterpreter::CommandInterpreter(World& world, std::ostream& out, uint64_t firstSequence)
+    : world(world), out(out), sequence(firstSequence), observer(nullptr), deferred(nullptr) {
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle)
+    handles.emplace(world.characters[handle].getName(), handle);
+}
+// The observers watch the world only while the interpreter exists.
+CommandInterpreter::~CommandInterpreter() {
+  if (attached() != nullptr)
+    observeWorld(world, nullptr);
+}
+WorldObserver* CommandInterpreter::attached() {
+  if (index && observer != nullptr)
+    return &observers;
+  return index ? index.get() : observer;
+}
+void CommandInterpreter::attach() {
+  observers = WorldObservers();
+  if (index && observer != nullptr) {
+    observers.add(index.get());
+    observers.add(observer);
+  }
+  observeWorld(world, attached());
+}
+void CommandInterpreter::setObserver(WorldObserver* worldObserver) {
+  observer = worldObserver;
+  attach();
+}
+void CommandInterpreter::deferUses(std::vector<SessionEvent>* events) {
+  deferred = events;
+}
+bool CommandInterpreter::handleOf(std::string_view name, uint32_t& handle) const {
+  if (!Name::fits(name))
+    return false;
+  auto found = handles.find(Name(name));
+  if (found == handles.end())
+    return false;
+  handle = found->second;
+  return true;
+}
+bool CommandInterpreter::create(TokenCursor& tokens) {
+  switch (keywordOf(tokens.next())) {
+    case Keyword::Character:
+      return createCharacter(tokens);
+    case Keyword::Item:
+      return createItem(tokens);
+    default:
+      return false;
+  }
+}
+bool CommandInterpreter::createCharacter(TokenCursor& tokens) {
+  std::string_view type = tokens.next();
+  Capacities capacities;
+  switch (keywordOf(type)) {
+    case Keyword::Fighter:
+      capacities = {3, 5, 0};
+      break;
+    case Keyword::Archer:
+      capacities = {2, 3, 2};
+      break;
+    case Keyword::Wizard:
+      capacities = {0, 10, 10};
+      break;
+    default:
+      return false;
+  }
+  std::string_view name = tokens.next();
+  int healthPoints;
+  if (name.empty() || !Name::fits(name) || !nextNumber(tokens, healthPoints) || healthPoints <= 0 || !tokens.atEnd() ||
+      handles.contains(Name(name)))
+    return false;
+  uint32_t handle = static_cast<uint32_t>(world.characters.size());
+  // Copies made while a vector grows lose their observer, so a reallocation
+  // means observing the whole world again.
+  bool reallocates = world.characters.size() == world.characters.capacity() ||
+                     world.arsenals.size() == world.arsenals.capacity() ||
+                     world.medicalBags.size() == world.medicalBags.capacity() ||
+                     world.spellBooks.size() == world.spellBooks.capacity();
+  handles.emplace(Name(name), handle);
+  world.characters.emplace_back(Name(name), healthPoints);
+  world.arsenals.emplace_back(capacities.weapons);
+  world.medicalBags.emplace_back(capacities.potions);
+  world.spellBooks.emplace_back(capacities.spells);
+  if (WorldObserver* current = attached()) {
+    if (reallocates) {
+      observeWorld(world, current);
+    } else {
+      world.characters[handle].setObserver(current);
+      world.arsenals[handle].setObserver(current);
+      world.medicalBags[handle].setObserver(current);
+      world.spellBooks[handle].setObserver(current);
+    }
+    current->onCharacterAdded(world, handle);
+  }
+  out << "A new " << type << " came to town, " << name << ".\n";
+  return true;
+}
+bool CommandInterpreter::createItem(TokenCursor& tokens) {
+  Keyword kind = keywordOf(tokens.next());
+  uint32_t owner;
+  if (!handleOf(tokens.next(), owner))
+    return false;
+  std::string_view name = tokens.next();
+  int value;
+  if (name.empty() || !Name::fits(name) || !nextNumber(tokens, value))
+    return false;
+  const Character& character = world.characters[owner];
+  ErrorCode error;
+  switch (kind) {
+    case Keyword::Weapon:
+      error = tokens.atEnd() ? addChecked(world.arsenals[owner], Weapon(character, Name(name), value))
+                             : ErrorCode::InvalidValue;
+      break;
+    case Keyword::Potion:
+      error = tokens.atEnd() ? addChecked(world.medicalBags[owner], Potion(character, Name(name), value))
+                             : ErrorCode::InvalidValue;
+      break;
+    case Keyword::Spell: {
+      AllocationTag tag("Spell::allowedTargets");
+      std::vector<Character> allowedTargets;
+      for (int i = 0; i < value; ++i) {
+        uint32_t target;
+        if (!handleOf(tokens.next(), target))
+          return false;
+        allowedTargets.push_back(world.characters[target]);
+      }
+      error = value >= 0 && tokens.atEnd()
+                  ? addChecked(world.spellBooks[owner], Spell(character, Name(name), allowedTargets))
+                  : ErrorCode::InvalidValue;
+      break;
+    }
+    default:
+      return false;
+  }
+  if (error != ErrorCode::Ok)
+    return false;
+  out << character.getName() << " just obtained a new " << keywordNames[static_cast<size_t>(kind)] << " called "
+      << name << ".\n";
+  return true;
+}
+bool CommandInterpreter::use(ItemKind kind, TokenCursor& tokens) {
+  SessionEvent event{sequence++, kind, 0, 0, {}};
+  if (!handleOf(tokens.next(), event.user) || !handleOf(tokens.next(), event.target))
+    return false;
+  event.item = tokens.next();
+  if (event.item.empty() || !Name::fits(event.item) || !tokens.atEnd())
+    return false;
+  if (deferred != nullptr)
+    deferred->push_back(std::move(event));
+  else
+    runEvent(world, event, out);
+  return true;
+}
+bool CommandInterpreter::attack(TokenCursor& tokens) {
+  return use(ItemKind::Weapon, tokens);
+}
+bool CommandInterpreter::cast(TokenCursor& tokens) {
+  return use(ItemKind::Spell, tokens);
+}
+bool CommandInterpreter::drink(TokenCursor& tokens) {
+  return use(ItemKind::Potion, tokens);
+}
+bool CommandInterpreter::dialogue(TokenCursor& tokens) {
+  std::string_view speaker = tokens.next();
+  uint32_t handle;
+  int count;
+  if ((speaker != "Narrator" && !handleOf(speaker, handle)) || !nextNumber(tokens, count) || count < 0)
+    return false;
+  AllocationTag tag("dialogue formatting");
+  std::string line(speaker);
+  line += ':';
+  for (int i = 0; i < count; ++i) {
+    std::string_view word = tokens.next();
+    if (word.empty())
+      return false;
+    line += ' ';
+    line += word;
+  }
+  if (!tokens.atEnd())
+    return false;
+  out << line << '\n';
+  return true;
+}
+bool CommandInterpreter::show(TokenCursor& tokens) {
+  AllocationTag tag("show formatting");
+  Keyword what = keywordOf(tokens.next());
+  if (what == Keyword::Characters) {
+    if (!tokens.atEnd())
+      return false;
+    bool first = true;
+    for (const Character& character : world.characters) {
+      out << (first ? "" : " ") << character;
+      first = false;
+    }
+    out << '\n';
+    return true;
+  }
+  uint32_t owner;
+  if (!handleOf(tokens.next(), owner) || !tokens.atEnd())
+    return false;
+  switch (what) {
+    case Keyword::Weapons:
+      showItems(out, world.arsenals[owner]);
+      return true;
+    case Keyword::Potions:
+      showItems(out, world.medicalBags[owner]);
+      return true;
+    case Keyword::Spells:
+      showItems(out, world.spellBooks[owner]);
+      return true;
+    default:
+      return false;
+  }
+}
+bool CommandInterpreter::query(TokenCursor& tokens) {
+  std::array<std::string_view, 4> words;
+  size_t count = 0;
+  while (!tokens.atEnd()) {
+    if (count == words.size())
+      return false;
+    words[count++] = tokens.next();
+  }
+  if (!index) {
+    index = std::make_unique<WorldIndex>(world);
+    attach();
+  }
+  return index->query(std::span(words.data(), count), out) == ErrorCode::Ok;
+}
+bool CommandInterpreter::unknown(TokenCursor&) {
+  return false;
+}
+static_assert(static_cast<size_t>(ProfileSlot::Query) == static_cast<size_t>(Keyword::Query));
+void CommandInterpreter::execute(const CommandBatch& batch, const CommandRecord& record) {
+  ProfileScope scope(record.keyword <= Keyword::Query ? static_cast<ProfileSlot>(record.keyword)
+                                                      : ProfileSlot::Invalid);
+  const TokenRef* first = batch.tokens.data() + record.firstToken;
+  TokenCursor tokens(batch.text, first, first + record.tokenCount);
+  if (!(this->*handlers[static_cast<size_t>(record.keyword)])(tokens))
+    out << "Error caught\n";
+}
+void CommandInterpreter::execute(const CommandBatch& batch) {
+  for (const CommandRecord& record : batch.records)
+    execute(batch, record);
+}
+void CommandInterpreter::execute(std::string_view line) {
+  parseCommands(line, lineBatch);
+  execute(lineBatch);
+}
+void CommandInterpreter::run(std::istream& in) {
+  for (std::string line; std::getline(in, line);)
+    execute(line);
+}
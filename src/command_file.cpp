@@ -0,0 +1,194 @@
+#include "game/command_file.h"
+#include "game/lz4.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Position just past the first '\n' at or after from, or the end of text.
+size_t lineBoundary(std::string_view text, size_t from) {
+  if (from >= text.size())
+    return text.size();
+  size_t newline = text.find('\n', from);
+  return newline == std::string_view::npos ? text.size() : newline + 1;
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path) : address(nullptr), length(0) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Error caught");
+  struct stat info {};
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    length = static_cast<size_t>(info.st_size);
+    address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED)
+      madvise(address, length, MADV_SEQUENTIAL);
+  }
+  close(fd);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("Error caught");
+}
+MappedFile::~MappedFile() {
+  if (address != nullptr)
+    munmap(address, length);
+}
+std::string_view MappedFile::text() const {
+  return {static_cast<const char*>(address), length};
+}
+
+void parseChunks(std::string_view text, std::vector<CommandBatch>& batches, size_t threads) {
+  batches.resize(std::max<size_t>(threads, 1));
+  std::vector<std::thread> workers;
+  size_t start = 0;
+  for (size_t chunk = 0; chunk < batches.size(); ++chunk) {
+    size_t end = text.size();
+    if (chunk + 1 < batches.size())
+      end = std::max(start, lineBoundary(text, text.size() / batches.size() * (chunk + 1)));
+    std::string_view piece = text.substr(start, end - start);
+    if (chunk + 1 == batches.size())
+      parseCommands(piece, batches[chunk]);
+    else
+      workers.emplace_back(parseCommands, piece, std::ref(batches[chunk]));
+    start = end;
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+}
+// Two sets of batches alternate, so the next window is parsed into one while
+// the other executes and each keeps its allocations across windows.
+bool forEachCommandBatch(std::string_view text, const std::function<bool(const CommandBatch&)>& execute, size_t threads,
+                         size_t windowBytes) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::array<std::vector<CommandBatch>, 2> windows;
+  size_t position = 0;
+  auto parseWindow = [&](std::vector<CommandBatch>& batches) {
+    size_t end = lineBoundary(text, std::min(text.size(), position + windowBytes));
+    parseChunks(text.substr(position, end - position), batches, threads);
+    position = end;
+  };
+  parseWindow(windows[0]);
+  for (size_t current = 0;; current ^= 1) {
+    bool more = position < text.size();
+    std::future<void> parsing;
+    if (more)
+      parsing = std::async(std::launch::async, parseWindow, std::ref(windows[current ^ 1]));
+    for (const CommandBatch& batch : windows[current]) {
+      if (!execute(batch))
+        return false;
+    }
+    if (!more)
+      return true;
+    parsing.get();
+  }
+}
+void runCommandText(std::string_view text, CommandInterpreter& interpreter, size_t threads, size_t windowBytes) {
+  forEachCommandBatch(
+      text,
+      [&](const CommandBatch& batch) {
+        interpreter.execute(batch);
+        return true;
+      },
+      threads, windowBytes);
+}
+// Blocks of a window decompress into fixed maxBlockSize slots after the
+// carried partial line, then are packed together; a block never expands
+// past its slot, so workers need no coordination.
+bool forEachCompressedBatch(std::string_view archive, const std::function<bool(const CommandBatch&)>& execute,
+                            size_t threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<lz4::Block> blocks = lz4::frameBlocks(archive);
+  size_t blocksPerWindow = 2 * threads;
+  std::array<std::string, 2> windows;
+  std::string carry;
+  size_t nextBlock = 0;
+  auto decompressWindow = [&](std::string& window) {
+    size_t first = nextBlock;
+    size_t count = std::min(blocksPerWindow, blocks.size() - first);
+    nextBlock += count;
+    window.resize(carry.size() + count * lz4::maxBlockSize);
+    std::memcpy(window.data(), carry.data(), carry.size());
+    std::vector<size_t> sizes(count);
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < std::min(threads, count); ++worker)
+      workers.emplace_back([&, worker] {
+        for (size_t i = worker; i < count; i += threads) {
+          const lz4::Block& block = blocks[first + i];
+          char* slot = window.data() + carry.size() + i * lz4::maxBlockSize;
+          if (!block.compressed) {
+            std::memcpy(slot, block.data, block.size);
+            sizes[i] = block.size;
+          } else {
+            std::optional<size_t> size = lz4::decompressBlock(block.data, block.size, slot, lz4::maxBlockSize);
+            sizes[i] = size ? *size : SIZE_MAX;
+          }
+        }
+      });
+    for (std::thread& worker : workers)
+      worker.join();
+    size_t end = carry.size();
+    for (size_t i = 0; i < count; ++i) {
+      if (sizes[i] == SIZE_MAX)
+        throw std::runtime_error("Error caught");
+      std::memmove(window.data() + end, window.data() + carry.size() + i * lz4::maxBlockSize, sizes[i]);
+      end += sizes[i];
+    }
+    window.resize(end);
+    size_t cut = nextBlock == blocks.size() ? end : window.rfind('\n') + 1;
+    carry.assign(window, cut, std::string::npos);
+    window.resize(cut);
+  };
+  decompressWindow(windows[0]);
+  for (size_t current = 0;; current ^= 1) {
+    bool more = nextBlock < blocks.size();
+    std::future<void> decompressing;
+    if (more)
+      decompressing = std::async(std::launch::async, decompressWindow, std::ref(windows[current ^ 1]));
+    if (!forEachCommandBatch(windows[current], execute, threads))
+      return false;
+    if (!more)
+      return true;
+    decompressing.get();
+  }
+}
+void runCompressedCommands(std::string_view archive, CommandInterpreter& interpreter, size_t threads) {
+  forEachCompressedBatch(
+      archive,
+      [&](const CommandBatch& batch) {
+        interpreter.execute(batch);
+        return true;
+      },
+      threads);
+}
+bool forEachInputBatch(std::string_view input, const std::function<bool(const CommandBatch&)>& execute,
+                       size_t threads) {
+  if (lz4::isFrame(input))
+    return forEachCompressedBatch(input, execute, threads);
+  return forEachCommandBatch(input, execute, threads);
+}
+void runCommandInput(std::string_view input, CommandInterpreter& interpreter, size_t threads) {
+  forEachInputBatch(
+      input,
+      [&](const CommandBatch& batch) {
+        interpreter.execute(batch);
+        return true;
+      },
+      threads);
+}
@@ -0,0 +1,99 @@
+#include "game/compressed_output.h"
+#include "game/lz4.h"
+
+#include <algorithm>
+
+CompressingStreamBuffer::CompressingStreamBuffer(std::ostream& target, size_t blockSize, size_t queueDepth)
+    : target(target),
+      blockSize(std::clamp<size_t>(blockSize, 1, lz4::maxBlockSize)),
+      queueDepth(std::max<size_t>(queueDepth, 1)),
+      filling(this->blockSize),
+      closing(false),
+      finished(false),
+      bytesIn(0),
+      bytesOut(0),
+      worker(&CompressingStreamBuffer::compressLoop, this) {
+  setp(filling.data(), filling.data() + filling.size());
+}
+CompressingStreamBuffer::~CompressingStreamBuffer() {
+  finish();
+}
+// Hands the buffered text to the compressor and continues in a recycled
+// buffer, so steady-state output does not allocate.
+void CompressingStreamBuffer::submit() {
+  size_t size = static_cast<size_t>(pptr() - pbase());
+  if (size > 0) {
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [this] { return pending.size() < queueDepth; });
+    filling.resize(size);
+    pending.push_back(std::move(filling));
+    filling = std::vector<char>();
+    if (!spare.empty()) {
+      filling = std::move(spare.back());
+      spare.pop_back();
+    }
+    bytesIn += size;
+    changed.notify_all();
+  }
+  filling.resize(blockSize);
+  setp(filling.data(), filling.data() + filling.size());
+}
+void CompressingStreamBuffer::compressLoop() {
+  std::string scratch;
+  for (;;) {
+    std::vector<char> block;
+    {
+      std::unique_lock lock(mutex);
+      changed.wait(lock, [this] { return !pending.empty() || closing; });
+      if (pending.empty())
+        return;
+      block = std::move(pending.front());
+      pending.pop_front();
+      changed.notify_all();
+    }
+    lz4::writeFrameHeader(target);
+    size_t written = lz4::writeBlock(target, block.data(), block.size(), scratch);
+    lz4::writeFrameEnd(target);
+    std::lock_guard lock(mutex);
+    bytesOut += lz4::frameHeaderSize + written + lz4::frameEndSize;
+    spare.push_back(std::move(block));
+  }
+}
+CompressingStreamBuffer::int_type CompressingStreamBuffer::overflow(int_type character) {
+  if (finished)
+    return traits_type::eof();
+  submit();
+  if (!traits_type::eq_int_type(character, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(character);
+    pbump(1);
+  }
+  return traits_type::not_eof(character);
+}
+// A flush ends the current frame. It does not wait for the compressor;
+// finish() does.
+int CompressingStreamBuffer::sync() {
+  if (!finished)
+    submit();
+  return 0;
+}
+void CompressingStreamBuffer::finish() {
+  if (finished)
+    return;
+  submit();
+  {
+    std::lock_guard lock(mutex);
+    closing = true;
+  }
+  changed.notify_all();
+  worker.join();
+  target.flush();
+  finished = true;
+  setp(nullptr, nullptr);
+}
+// Both counters are final once finish() has returned.
+uint64_t CompressingStreamBuffer::uncompressedBytes() const {
+  return bytesIn;
+}
+uint64_t CompressingStreamBuffer::compressedBytes() const {
+  return bytesOut;
+}
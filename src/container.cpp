@@ -0,0 +1,10 @@
+#include "game/container.h"
+
+// The three item containers are instantiated once here instead of in every
+// translation unit that includes container.h.
+template class Container<Weapon>;
+template class Container<Potion>;
+template class Container<Spell>;
+template class ContainerWithMaxCapacity<Weapon>;
+template class ContainerWithMaxCapacity<Potion>;
+template class ContainerWithMaxCapacity<Spell>;
@@ -0,0 +1,155 @@
+#include "game/cycle_profiler.h"
+
+#include <chrono>
+#include <iomanip>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+thread_local CycleProfiler* current = nullptr;
+
+int openCounter(uint64_t config, int group) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+uint64_t timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+}  // namespace
+
+HardwareCounters::HardwareCounters() : leader(-1), descriptors() {
+  descriptors.fill(-1);
+  constexpr std::array<uint64_t, counterCount> configs = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                          PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  leader = openCounter(configs[0], -1);
+  if (leader < 0)
+    return;
+  descriptors[0] = leader;
+  for (size_t i = 1; i < counterCount; ++i)
+    descriptors[i] = openCounter(configs[i], leader);
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+HardwareCounters::~HardwareCounters() {
+  for (int descriptor : descriptors)
+    if (descriptor >= 0)
+      close(descriptor);
+}
+bool HardwareCounters::usesPerf() const {
+  return leader >= 0;
+}
+bool HardwareCounters::has(size_t counter) const {
+  return counter == 0 || descriptors[counter] >= 0;
+}
+// A group read returns the member count followed by one value per member,
+// in the order the members were opened.
+CounterSample HardwareCounters::read() const {
+  CounterSample sample;
+  if (leader < 0) {
+    sample.cycles = timestamp();
+    return sample;
+  }
+  std::array<uint64_t, 1 + counterCount> values{};
+  if (::read(leader, values.data(), sizeof(values)) <= 0)
+    return sample;
+  std::array<uint64_t*, counterCount> fields = {&sample.cycles, &sample.instructions, &sample.cacheMisses,
+                                                &sample.branchMisses};
+  size_t member = 1;
+  for (size_t i = 0; i < counterCount; ++i)
+    if (descriptors[i] >= 0)
+      *fields[i] = values[member++];
+  return sample;
+}
+
+CycleProfiler::CycleProfiler() : counters(), totals(), previous(current) {
+  current = this;
+}
+CycleProfiler::~CycleProfiler() {
+  current = previous;
+}
+CycleProfiler* CycleProfiler::active() {
+  return current;
+}
+CounterSample CycleProfiler::read() const {
+  return counters.read();
+}
+void CycleProfiler::add(ProfileSlot slot, const CounterSample& start, const CounterSample& end) {
+  Totals& slotTotals = totals[static_cast<size_t>(slot)];
+  ++slotTotals.samples;
+  slotTotals.sum.cycles += end.cycles - start.cycles;
+  slotTotals.sum.instructions += end.instructions - start.instructions;
+  slotTotals.sum.cacheMisses += end.cacheMisses - start.cacheMisses;
+  slotTotals.sum.branchMisses += end.branchMisses - start.branchMisses;
+}
+// Shares of the cache-miss total are taken over command slots only, since
+// the useLogic slots are already counted inside the commands.
+void CycleProfiler::report(std::ostream& report) const {
+  uint64_t commandMisses = 0;
+  for (size_t slot = 0; slot <= static_cast<size_t>(ProfileSlot::Invalid); ++slot)
+    commandMisses += totals[slot].sum.cacheMisses;
+  report << (counters.usesPerf() ? "perf_event counters" : "rdtsc only, perf_event unavailable") << '\n'
+         << std::left << std::setw(18) << "slot" << std::right << std::setw(10) << "samples" << std::setw(12)
+         << "cycles" << std::setw(12) << "instr" << std::setw(7) << "IPC" << std::setw(12) << "cache-miss"
+         << std::setw(12) << "branch-miss" << std::setw(9) << "miss%" << '\n';
+  auto perSample = [](uint64_t total, uint64_t samples) { return static_cast<double>(total) / samples; };
+  report << std::fixed << std::setprecision(1);
+  for (size_t slot = 0; slot < profileSlotCount; ++slot) {
+    const Totals& slotTotals = totals[slot];
+    if (slotTotals.samples == 0)
+      continue;
+    report << std::left << std::setw(18) << profileSlotNames[slot] << std::right << std::setw(10)
+           << slotTotals.samples << std::setw(12) << perSample(slotTotals.sum.cycles, slotTotals.samples);
+    if (counters.has(1))
+      report << std::setw(12) << perSample(slotTotals.sum.instructions, slotTotals.samples) << std::setw(7)
+             << std::setprecision(2) << perSample(slotTotals.sum.instructions, slotTotals.sum.cycles)
+             << std::setprecision(1);
+    else
+      report << std::setw(12) << '-' << std::setw(7) << '-';
+    report << std::setw(12);
+    if (counters.has(2))
+      report << perSample(slotTotals.sum.cacheMisses, slotTotals.samples);
+    else
+      report << '-';
+    report << std::setw(12);
+    if (counters.has(3))
+      report << perSample(slotTotals.sum.branchMisses, slotTotals.samples);
+    else
+      report << '-';
+    report << std::setw(9);
+    if (counters.has(2) && commandMisses > 0 && slot <= static_cast<size_t>(ProfileSlot::Invalid))
+      report << 100.0 * perSample(slotTotals.sum.cacheMisses, commandMisses);
+    else
+      report << '-';
+    report << '\n';
+  }
+  report << std::defaultfloat << std::setprecision(6);
+}
+
+ProfileScope::ProfileScope(ProfileSlot slot) : profiler(CycleProfiler::active()), slot(slot), start() {
+  if (profiler != nullptr)
+    start = profiler->read();
+}
+ProfileScope::~ProfileScope() {
+  if (profiler != nullptr)
+    profiler->add(slot, start, profiler->read());
+}
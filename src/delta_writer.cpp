@@ -0,0 +1,179 @@
+#include "game/delta_writer.h"
+
+#include <charconv>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char* kindName(const PhysicalItem& item) {
+  if (dynamic_cast<const Weapon*>(&item) != nullptr)
+    return "weapon";
+  if (dynamic_cast<const Potion*>(&item) != nullptr)
+    return "potion";
+  return "spell";
+}
+bool parseNumber(std::string_view token, int& value) {
+  auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+  return !token.empty() && error == std::errc() && end == token.data() + token.size();
+}
+
+// Reads the words of one delta line and resolves character names.
+class DeltaLine {
+ private:
+  std::istringstream words;
+  const std::unordered_map<Name, uint32_t>& handles;
+
+ public:
+  DeltaLine(const std::string& line, const std::unordered_map<Name, uint32_t>& handles)
+      : words(line), handles(handles) {}
+  bool word(std::string& value) {
+    return static_cast<bool>(words >> value);
+  }
+  bool name(Name& value) {
+    std::string text;
+    if (!word(text) || !Name::fits(text))
+      return false;
+    value = Name(text);
+    return true;
+  }
+  bool number(int& value) {
+    std::string text;
+    return word(text) && parseNumber(text, value);
+  }
+  bool handle(uint32_t& value) {
+    Name owner;
+    if (!name(owner))
+      return false;
+    auto found = handles.find(owner);
+    if (found == handles.end())
+      return false;
+    value = found->second;
+    return true;
+  }
+  bool atEnd() {
+    std::string rest;
+    return !(words >> rest);
+  }
+};
+
+template <PhysicalDerived T>
+ErrorCode consume(ContainerWithMaxCapacity<T>& container, const Name& name) {
+  std::optional<T> item = container.find(name);
+  if (!item)
+    return ErrorCode::ItemNotFound;
+  item->setUsed(true);
+  container.remove(name);
+  return container.add(*item);
+}
+template <PhysicalDerived T>
+ErrorCode applyToContainer(World& world, DeltaLine& line, char tag, ContainerWithMaxCapacity<T>& container,
+                           uint32_t owner) {
+  Name name;
+  if (!line.name(name))
+    return ErrorCode::InvalidValue;
+  if (tag == '-')
+    return line.atEnd() ? container.remove(name) : ErrorCode::InvalidValue;
+  if (tag == 'U')
+    return line.atEnd() ? consume(container, name) : ErrorCode::InvalidValue;
+  int value;
+  if (!line.number(value))
+    return ErrorCode::InvalidValue;
+  const Character& character = world.characters[owner];
+  if constexpr (std::is_same_v<T, Spell>) {
+    std::vector<Character> targets;
+    for (int i = 0; i < value; ++i) {
+      Name target;
+      if (!line.name(target))
+        return ErrorCode::InvalidValue;
+      targets.emplace_back(target, 1);
+    }
+    return line.atEnd() ? container.add(Spell(character, name, targets)) : ErrorCode::InvalidValue;
+  } else {
+    return line.atEnd() ? container.add(T(character, name, value)) : ErrorCode::InvalidValue;
+  }
+}
+
+}  // namespace
+
+DeltaWriter::DeltaWriter(std::ostream& out) : out(out) {}
+void DeltaWriter::onCharacterAdded(const World& world, uint32_t handle) {
+  const Character& character = world.characters[handle];
+  out << "C " << character.getName() << ' ' << character.getHP() << ' ' << world.arsenals[handle].getMaxCapacity()
+      << ' ' << world.medicalBags[handle].getMaxCapacity() << ' ' << world.spellBooks[handle].getMaxCapacity()
+      << '\n';
+}
+void DeltaWriter::onHealthChanged(const Character& character, int) {
+  out << "H " << character.getName() << ' ' << character.getHP() << '\n';
+}
+void DeltaWriter::onItemAdded(const PhysicalItem& item) {
+  out << "+ " << kindName(item) << ' ' << item.getOwnerName() << ' ' << item.getName() << ' ';
+  if (const Weapon* weapon = dynamic_cast<const Weapon*>(&item)) {
+    out << weapon->getDamage();
+  } else if (const Potion* potion = dynamic_cast<const Potion*>(&item)) {
+    out << potion->getHealValue();
+  } else {
+    const Spell& spell = static_cast<const Spell&>(item);
+    out << spell.getNumAllowedTargets();
+    for (const Name& target : spell.getAllowedTargets())
+      out << ' ' << target;
+  }
+  out << '\n';
+}
+void DeltaWriter::onItemRemoved(const PhysicalItem& item) {
+  out << "- " << kindName(item) << ' ' << item.getOwnerName() << ' ' << item.getName() << '\n';
+}
+void DeltaWriter::onItemConsumed(const PhysicalItem& item) {
+  out << "U " << kindName(item) << ' ' << item.getOwnerName() << ' ' << item.getName() << '\n';
+}
+
+ErrorCode applyDeltas(std::istream& in, World& world) {
+  std::unordered_map<Name, uint32_t> handles;
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle)
+    handles.emplace(world.characters[handle].getName(), handle);
+  for (std::string text; std::getline(in, text);) {
+    DeltaLine line(text, handles);
+    std::string tag;
+    if (!line.word(tag))
+      continue;
+    ErrorCode error = ErrorCode::InvalidValue;
+    if (tag == "C") {
+      Name name;
+      int healthPoints, weapons, potions, spells;
+      if (!line.name(name) || !line.number(healthPoints) || !line.number(weapons) || !line.number(potions) ||
+          !line.number(spells) || !line.atEnd() || handles.contains(name) || weapons < 0 || potions < 0 ||
+          spells < 0)
+        return ErrorCode::InvalidValue;
+      handles.emplace(name, static_cast<uint32_t>(world.characters.size()));
+      world.characters.emplace_back(name, healthPoints);
+      world.arsenals.emplace_back(weapons);
+      world.medicalBags.emplace_back(potions);
+      world.spellBooks.emplace_back(spells);
+      error = ErrorCode::Ok;
+    } else if (tag == "H") {
+      uint32_t handle;
+      int healthPoints;
+      if (!line.handle(handle) || !line.number(healthPoints) || !line.atEnd())
+        return ErrorCode::InvalidValue;
+      world.characters[handle] = Character(world.characters[handle].getName(), healthPoints);
+      error = ErrorCode::Ok;
+    } else if (tag == "+" || tag == "-" || tag == "U") {
+      std::string kind;
+      uint32_t owner;
+      if (!line.word(kind) || !line.handle(owner))
+        return ErrorCode::InvalidValue;
+      if (kind == "weapon")
+        error = applyToContainer(world, line, tag[0], world.arsenals[owner], owner);
+      else if (kind == "potion")
+        error = applyToContainer(world, line, tag[0], world.medicalBags[owner], owner);
+      else if (kind == "spell")
+        error = applyToContainer(world, line, tag[0], world.spellBooks[owner], owner);
+    }
+    if (error != ErrorCode::Ok)
+      return error;
+  }
+  return ErrorCode::Ok;
+}
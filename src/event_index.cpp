@@ -0,0 +1,187 @@
+#include "game/event_index.h"
+#include "game/command.h"
+#include "game/snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// The next line of log at or after position, without its '\n'. Advances
+// position past the line.
+std::string_view nextLine(std::string_view log, uint64_t& position) {
+  size_t end = log.find('\n', position);
+  if (end == std::string_view::npos)
+    end = log.size();
+  std::string_view line = log.substr(position, end - position);
+  position = std::min<uint64_t>(log.size(), end + 1);
+  return line;
+}
+// The line's first word, empty for a line that is not an event.
+std::string_view firstWord(std::string_view line) {
+  size_t start = line.find_first_not_of(" \t\r");
+  if (start == std::string_view::npos)
+    return {};
+  size_t end = line.find_first_of(" \t\r", start);
+  return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
+// Mirrors CommandInterpreter: every Attack, Cast or Drink takes a sequence
+// number, whether or not it succeeds.
+bool takesSequence(std::string_view word) {
+  Keyword keyword = keywordOf(word);
+  return keyword == Keyword::Attack || keyword == Keyword::Cast || keyword == Keyword::Drink;
+}
+
+}  // namespace
+
+EventIndex::EventIndex() : interval(1), eventCount(0), logSize(0), hasSnapshots(false) {}
+// One pass over the log. With a snapshot path the events are also executed,
+// output discarded, so the world can be saved at each checkpoint. Throws if
+// a snapshot cannot be written.
+EventIndex EventIndex::build(std::string_view log, uint32_t interval, const std::string& snapshotPath) {
+  EventIndex index;
+  index.interval = std::max<uint32_t>(interval, 1);
+  index.logSize = log.size();
+  index.hasSnapshots = !snapshotPath.empty();
+  World world;
+  std::ostream discard(nullptr);
+  CommandInterpreter interpreter(world, discard);
+  uint64_t sequence = 0;
+  for (uint64_t position = 0; position < log.size();) {
+    uint64_t lineStart = position;
+    std::string_view line = nextLine(log, position);
+    std::string_view word = firstWord(line);
+    if (word.empty())
+      continue;
+    if (index.eventCount % index.interval == 0) {
+      if (index.hasSnapshots && !saveSnapshot(world, checkpointSnapshotPath(snapshotPath, index.checkpoints.size())))
+        throw std::runtime_error("Error caught");
+      index.checkpoints.push_back({index.eventCount, lineStart, sequence});
+    }
+    if (index.hasSnapshots)
+      interpreter.execute(line);
+    if (takesSequence(word))
+      ++sequence;
+    ++index.eventCount;
+  }
+  return index;
+}
+// Rejects anything build() could not have written: a zero interval, a
+// checkpoint count that does not match the event count or the bytes left in
+// the stream, and checkpoints out of order or past the end of the log.
+EventIndex EventIndex::read(std::istream& in) {
+  EventIndexHeader header{};
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, eventIndexMagic, sizeof(eventIndexMagic)) != 0 || header.version != eventIndexVersion)
+    throw std::runtime_error("Error caught");
+  std::streampos start = in.tellg();
+  in.seekg(0, std::ios::end);
+  std::streampos end = in.tellg();
+  in.seekg(start);
+  if (header.interval == 0 || start < 0 || end < start || !in ||
+      header.checkpointCount != header.eventCount / header.interval + (header.eventCount % header.interval != 0) ||
+      header.checkpointCount != static_cast<uint64_t>(end - start) / sizeof(EventCheckpoint) ||
+      static_cast<uint64_t>(end - start) % sizeof(EventCheckpoint) != 0)
+    throw std::runtime_error("Error caught");
+  EventIndex index;
+  index.interval = header.interval;
+  index.eventCount = header.eventCount;
+  index.logSize = header.logSize;
+  index.hasSnapshots = header.hasSnapshots != 0;
+  index.checkpoints.resize(header.checkpointCount);
+  if (!in.read(reinterpret_cast<char*>(index.checkpoints.data()),
+               static_cast<std::streamsize>(index.checkpoints.size() * sizeof(EventCheckpoint))))
+    throw std::runtime_error("Error caught");
+  for (size_t number = 0; number < index.checkpoints.size(); ++number) {
+    const EventCheckpoint& checkpoint = index.checkpoints[number];
+    bool ordered = number == 0 || (checkpoint.offset > index.checkpoints[number - 1].offset &&
+                                   checkpoint.sequence >= index.checkpoints[number - 1].sequence);
+    if (checkpoint.event != number * index.interval || checkpoint.offset >= index.logSize ||
+        checkpoint.sequence > checkpoint.event || !ordered)
+      throw std::runtime_error("Error caught");
+  }
+  return index;
+}
+void EventIndex::write(std::ostream& out) const {
+  EventIndexHeader header{};
+  std::memcpy(header.magic, eventIndexMagic, sizeof(eventIndexMagic));
+  header.version = eventIndexVersion;
+  header.interval = interval;
+  header.eventCount = eventCount;
+  header.logSize = logSize;
+  header.checkpointCount = checkpoints.size();
+  header.hasSnapshots = hasSnapshots;
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(checkpoints.data()),
+            static_cast<std::streamsize>(checkpoints.size() * sizeof(EventCheckpoint)));
+}
+uint32_t EventIndex::getInterval() const {
+  return interval;
+}
+uint64_t EventIndex::getEventCount() const {
+  return eventCount;
+}
+uint64_t EventIndex::getLogSize() const {
+  return logSize;
+}
+bool EventIndex::snapshotsSaved() const {
+  return hasSnapshots;
+}
+size_t EventIndex::checkpointOf(uint64_t event) const {
+  return static_cast<size_t>(std::min<uint64_t>(event / interval, checkpoints.size() - 1));
+}
+const EventCheckpoint& EventIndex::checkpoint(size_t number) const {
+  return checkpoints[number];
+}
+// Fails for events past the end and for a log whose size no longer matches
+// the one indexed.
+std::optional<uint64_t> EventIndex::offsetOf(std::string_view log, uint64_t event) const {
+  if (event >= eventCount || log.size() != logSize)
+    return std::nullopt;
+  const EventCheckpoint& start = checkpoints[checkpointOf(event)];
+  uint64_t current = start.event;
+  for (uint64_t position = start.offset; position < log.size();) {
+    uint64_t lineStart = position;
+    if (firstWord(nextLine(log, position)).empty())
+      continue;
+    if (current++ == event)
+      return lineStart;
+  }
+  return std::nullopt;
+}
+
+std::string checkpointSnapshotPath(const std::string& indexPath, size_t checkpoint) {
+  return indexPath + '.' + std::to_string(checkpoint) + ".snap";
+}
+
+// Fails like offsetOf for a log that changed size since indexing, and for a
+// checkpoint snapshot that is missing or corrupt.
+bool printStateAt(std::string_view log, const EventIndex& index, const std::string& indexPath, uint64_t event,
+                  std::ostream& out) {
+  if (event > index.getEventCount() || index.getEventCount() == 0 || log.size() != index.getLogSize())
+    return false;
+  World world;
+  EventCheckpoint start{0, 0, 0};
+  if (index.snapshotsSaved()) {
+    size_t number = index.checkpointOf(event);
+    start = index.checkpoint(number);
+    try {
+      world = MappedSnapshot(checkpointSnapshotPath(indexPath, number)).view().restore();
+    } catch (const std::runtime_error&) {
+      return false;
+    }
+  }
+  std::ostream discard(nullptr);
+  CommandInterpreter replay(world, discard, start.sequence);
+  uint64_t current = start.event;
+  for (uint64_t position = start.offset; position < log.size() && current < event;) {
+    std::string_view line = nextLine(log, position);
+    if (firstWord(line).empty())
+      continue;
+    replay.execute(line);
+    ++current;
+  }
+  CommandInterpreter(world, out).execute("Show characters");
+  return true;
+}
@@ -0,0 +1,293 @@
+#include "game/formula.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+namespace {
+
+int64_t add(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+int64_t subtract(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+int64_t multiply(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+}
+int64_t divide(int64_t a, int64_t b) {
+  if (b == 0)
+    return 0;
+  return b == -1 ? subtract(0, a) : a / b;
+}
+
+}  // namespace
+
+// Recursive descent over the source. A subexpression at nesting depth d
+// either folds to a constant, names a variable register, or leaves its value
+// in temporary d, so deeper operands never clobber shallower ones.
+class Formula::Compiler {
+ private:
+  struct Operand {
+    bool isConstant;
+    int64_t value;
+    uint8_t reg;
+  };
+  std::string_view source;
+  size_t position;
+  Formula& formula;
+  bool failed;
+
+  void skipSpaces();
+  bool accept(char);
+  std::string identifier();
+  uint8_t temporary(uint8_t);
+  Operand emit(Op, uint8_t, uint8_t, uint8_t = 0, int64_t = 0);
+  Operand binary(Op, Operand, Operand, uint8_t);
+  Operand expression(uint8_t);
+  Operand term(uint8_t);
+  Operand unary(uint8_t);
+  Operand primary(uint8_t);
+
+ public:
+  Compiler(std::string_view, Formula&);
+  bool run();
+};
+Formula::Compiler::Compiler(std::string_view source, Formula& formula)
+    : source(source), position(0), formula(formula), failed(false) {}
+void Formula::Compiler::skipSpaces() {
+  while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position])))
+    ++position;
+}
+bool Formula::Compiler::accept(char expected) {
+  skipSpaces();
+  if (position < source.size() && source[position] == expected) {
+    ++position;
+    return true;
+  }
+  return false;
+}
+std::string Formula::Compiler::identifier() {
+  skipSpaces();
+  size_t start = position;
+  while (position < source.size() &&
+         (std::isalnum(static_cast<unsigned char>(source[position])) || source[position] == '_'))
+    ++position;
+  return std::string(source.substr(start, position - start));
+}
+uint8_t Formula::Compiler::temporary(uint8_t depth) {
+  if (firstTemporary + depth >= maxRegisters) {
+    failed = true;
+    return maxRegisters - 1;
+  }
+  return firstTemporary + depth;
+}
+Formula::Compiler::Operand Formula::Compiler::emit(Op op, uint8_t dst, uint8_t a, uint8_t b, int64_t immediate) {
+  formula.code.push_back({op, dst, a, b, immediate});
+  return {false, 0, dst};
+}
+Formula::Compiler::Operand Formula::Compiler::binary(Op op, Operand left, Operand right, uint8_t depth) {
+  if (left.isConstant && right.isConstant)
+    return {true, apply(op, left.value, right.value), 0};
+  bool commutative = op == Op::Add || op == Op::Mul || op == Op::Min || op == Op::Max;
+  if (left.isConstant && commutative)
+    std::swap(left, right);
+  uint8_t dst = temporary(depth);
+  auto withImmediate = static_cast<Op>(static_cast<uint8_t>(op) + static_cast<uint8_t>(Op::AddI) -
+                                       static_cast<uint8_t>(Op::Add));
+  if (right.isConstant)
+    return emit(withImmediate, dst, left.reg, 0, right.value);
+  if (left.isConstant)
+    left = emit(Op::Load, dst, 0, 0, left.value);
+  return emit(op, dst, left.reg, right.reg);
+}
+Formula::Compiler::Operand Formula::Compiler::expression(uint8_t depth) {
+  Operand left = term(depth);
+  while (!failed) {
+    if (accept('+'))
+      left = binary(Op::Add, left, term(depth + 1), depth);
+    else if (accept('-'))
+      left = binary(Op::Sub, left, term(depth + 1), depth);
+    else
+      break;
+  }
+  return left;
+}
+Formula::Compiler::Operand Formula::Compiler::term(uint8_t depth) {
+  Operand left = unary(depth);
+  while (!failed) {
+    if (accept('*'))
+      left = binary(Op::Mul, left, unary(depth + 1), depth);
+    else if (accept('/'))
+      left = binary(Op::Div, left, unary(depth + 1), depth);
+    else
+      break;
+  }
+  return left;
+}
+Formula::Compiler::Operand Formula::Compiler::unary(uint8_t depth) {
+  if (!accept('-'))
+    return primary(depth);
+  Operand operand = unary(depth);
+  if (operand.isConstant)
+    return {true, subtract(0, operand.value), 0};
+  return emit(Op::Neg, temporary(depth), operand.reg);
+}
+Formula::Compiler::Operand Formula::Compiler::primary(uint8_t depth) {
+  temporary(depth);
+  if (failed)
+    return {true, 0, 0};
+  if (accept('(')) {
+    Operand inner = expression(depth);
+    failed = failed || !accept(')');
+    return inner;
+  }
+  skipSpaces();
+  if (position < source.size() && std::isdigit(static_cast<unsigned char>(source[position]))) {
+    int64_t value = 0;
+    while (!failed && position < source.size() && std::isdigit(static_cast<unsigned char>(source[position]))) {
+      value = value * 10 + (source[position++] - '0');
+      failed = value > INT32_MAX;
+    }
+    return {true, value, 0};
+  }
+  std::string name = identifier();
+  if (name == "base")
+    return {false, 0, baseRegister};
+  if (name == "user_hp" || name == "target_hp") {
+    formula.readsHP = true;
+    return {false, 0, name == "user_hp" ? userHPRegister : targetHPRegister};
+  }
+  if ((name == "min" || name == "max") && accept('(')) {
+    Operand left = expression(depth);
+    failed = failed || !accept(',');
+    Operand right = expression(depth + 1);
+    failed = failed || !accept(')');
+    return binary(name == "min" ? Op::Min : Op::Max, left, right, depth);
+  }
+  if (name == "roll" && accept('(')) {
+    formula.rollsDice = true;
+    Operand sides = expression(depth);
+    failed = failed || !accept(')');
+    if (sides.isConstant)
+      return emit(Op::RollI, temporary(depth), 0, 0, sides.value);
+    return emit(Op::Roll, temporary(depth), sides.reg);
+  }
+  failed = true;
+  return {true, 0, 0};
+}
+bool Formula::Compiler::run() {
+  Operand value = expression(0);
+  skipSpaces();
+  if (failed || position != source.size())
+    return false;
+  if (value.isConstant)
+    value = emit(Op::Load, firstTemporary, 0, 0, value.value);
+  formula.result = value.reg;
+  return true;
+}
+
+Formula::Formula() : code(), result(baseRegister), readsHP(false), rollsDice(false), source() {}
+// Used for constant folding; execute() inlines the same helpers per opcode.
+int64_t Formula::apply(Op op, int64_t a, int64_t b) {
+  switch (op) {
+    case Op::Add:
+      return add(a, b);
+    case Op::Sub:
+      return subtract(a, b);
+    case Op::Mul:
+      return multiply(a, b);
+    case Op::Div:
+      return divide(a, b);
+    case Op::Min:
+      return std::min(a, b);
+    case Op::Max:
+      return std::max(a, b);
+    default:
+      return 0;
+  }
+}
+int64_t Formula::roll(int64_t sides, CombatRandom* random) {
+  if (sides <= 0)
+    return 0;
+  if (random == nullptr)
+    return sides;
+  if (sides <= UINT32_MAX)
+    return 1 + random->below(static_cast<uint32_t>(sides));
+  uint64_t bits = static_cast<uint64_t>(random->next()) << 32;
+  bits |= random->next();
+  return 1 + static_cast<int64_t>((static_cast<unsigned __int128>(bits) * static_cast<uint64_t>(sides)) >> 64);
+}
+std::optional<Formula> Formula::compile(std::string_view source) {
+  Formula formula;
+  if (!Compiler(source, formula).run())
+    return std::nullopt;
+  formula.source = source;
+  return formula;
+}
+int64_t Formula::execute(int64_t base, int64_t userHP, int64_t targetHP, CombatRandom* random) const {
+  int64_t reg[maxRegisters];
+  reg[baseRegister] = base;
+  reg[userHPRegister] = userHP;
+  reg[targetHPRegister] = targetHP;
+  for (const Instruction& in : code) {
+    switch (in.op) {
+      case Op::Load:
+        reg[in.dst] = in.immediate;
+        break;
+      case Op::Neg:
+        reg[in.dst] = subtract(0, reg[in.a]);
+        break;
+      case Op::Roll:
+        reg[in.dst] = roll(reg[in.a], random);
+        break;
+      case Op::RollI:
+        reg[in.dst] = roll(in.immediate, random);
+        break;
+      case Op::Add:
+        reg[in.dst] = add(reg[in.a], reg[in.b]);
+        break;
+      case Op::Sub:
+        reg[in.dst] = subtract(reg[in.a], reg[in.b]);
+        break;
+      case Op::Mul:
+        reg[in.dst] = multiply(reg[in.a], reg[in.b]);
+        break;
+      case Op::Div:
+        reg[in.dst] = divide(reg[in.a], reg[in.b]);
+        break;
+      case Op::Min:
+        reg[in.dst] = std::min(reg[in.a], reg[in.b]);
+        break;
+      case Op::Max:
+        reg[in.dst] = std::max(reg[in.a], reg[in.b]);
+        break;
+      case Op::AddI:
+        reg[in.dst] = add(reg[in.a], in.immediate);
+        break;
+      case Op::SubI:
+        reg[in.dst] = subtract(reg[in.a], in.immediate);
+        break;
+      case Op::MulI:
+        reg[in.dst] = multiply(reg[in.a], in.immediate);
+        break;
+      case Op::DivI:
+        reg[in.dst] = divide(reg[in.a], in.immediate);
+        break;
+      case Op::MinI:
+        reg[in.dst] = std::min(reg[in.a], in.immediate);
+        break;
+      case Op::MaxI:
+        reg[in.dst] = std::max(reg[in.a], in.immediate);
+        break;
+    }
+  }
+  return reg[result];
+}
+size_t Formula::getInstructionCount() const {
+  return code.size();
+}
+// Kept so a formula can be saved and compiled again, e.g. in snapshots.
+const std::string& Formula::getSource() const {
+  return source;
+}
@@ -0,0 +1,182 @@
+#include "game/game_session.h"
+#include "game/random.h"
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+GameSession::GameSession(size_t maxCharacters, int containerCapacity, uint64_t randomSeed)
+    : world(), maxCharacters(maxCharacters), containerCapacity(containerCapacity), commandCount(0) {
+  world.randomSeed = randomSeed;
+  world.characters.reserve(maxCharacters);
+  world.arsenals.reserve(maxCharacters);
+  world.medicalBags.reserve(maxCharacters);
+  world.spellBooks.reserve(maxCharacters);
+}
+bool GameSession::isValid(uint32_t handle) const {
+  return handle < world.characters.size();
+}
+template <PhysicalDerived T>
+ContainerWithMaxCapacity<T>& GameSession::containerOf(uint32_t handle) {
+  if constexpr (std::is_same_v<T, Weapon>)
+    return world.arsenals[handle];
+  else if constexpr (std::is_same_v<T, Potion>)
+    return world.medicalBags[handle];
+  else
+    return world.spellBooks[handle];
+}
+template <PhysicalDerived T>
+const ContainerWithMaxCapacity<T>& GameSession::containerOf(uint32_t handle) const {
+  return const_cast<GameSession*>(this)->containerOf<T>(handle);
+}
+ErrorCode GameSession::createCharacter(std::string_view name, int healthPoints, uint32_t& handle) {
+  if (world.characters.size() == maxCharacters)
+    return ErrorCode::ContainerFull;
+  if (healthPoints <= 0 || !Name::fits(name))
+    return ErrorCode::InvalidValue;
+  handle = static_cast<uint32_t>(world.characters.size());
+  world.characters.emplace_back(Name(name), healthPoints);
+  world.arsenals.emplace_back(containerCapacity);
+  world.medicalBags.emplace_back(containerCapacity);
+  world.spellBooks.emplace_back(containerCapacity);
+  return ErrorCode::Ok;
+}
+ErrorCode GameSession::createWeapon(uint32_t owner, std::string_view name, int damage) {
+  if (!isValid(owner))
+    return ErrorCode::InvalidHandle;
+  if (!Name::fits(name))
+    return ErrorCode::InvalidValue;
+  Weapon weapon(world.characters[owner], Name(name), damage);
+  if (ErrorCode error = weapon.setup(); error != ErrorCode::Ok)
+    return error;
+  return world.arsenals[owner].add(std::move(weapon));
+}
+ErrorCode GameSession::createPotion(uint32_t owner, std::string_view name, int healValue) {
+  if (!isValid(owner))
+    return ErrorCode::InvalidHandle;
+  if (!Name::fits(name))
+    return ErrorCode::InvalidValue;
+  Potion potion(world.characters[owner], Name(name), healValue);
+  if (ErrorCode error = potion.setup(); error != ErrorCode::Ok)
+    return error;
+  return world.medicalBags[owner].add(std::move(potion));
+}
+ErrorCode GameSession::createSpell(uint32_t owner, std::string_view name, std::span<const uint32_t> targets) {
+  if (!isValid(owner))
+    return ErrorCode::InvalidHandle;
+  if (!Name::fits(name))
+    return ErrorCode::InvalidValue;
+  std::vector<Character> allowedTargets;
+  allowedTargets.reserve(targets.size());
+  for (uint32_t target : targets) {
+    if (!isValid(target))
+      return ErrorCode::InvalidHandle;
+    allowedTargets.push_back(world.characters[target]);
+  }
+  return world.spellBooks[owner].add(Spell(world.characters[owner], Name(name), allowedTargets));
+}
+template <PhysicalDerived T>
+ErrorCode GameSession::setItemEffect(uint32_t owner, std::string_view itemName, std::shared_ptr<const Formula> formula) {
+  ContainerWithMaxCapacity<T>& container = containerOf<T>(owner);
+  std::optional<T> item = Name::fits(itemName) ? container.find(Name(itemName)) : std::nullopt;
+  if (!item)
+    return ErrorCode::ItemNotFound;
+  item->setEffect(std::move(formula));
+  container.remove(item->getName());
+  return container.add(std::move(*item));
+}
+// Compiles source once; the bytecode is shared by the item and its copies.
+// An empty source restores the item's fixed value.
+ErrorCode GameSession::setEffect(ItemKind kind, uint32_t owner, std::string_view itemName, std::string_view source) {
+  if (!isValid(owner))
+    return ErrorCode::InvalidHandle;
+  std::shared_ptr<const Formula> formula;
+  if (!source.empty()) {
+    std::optional<Formula> compiled = Formula::compile(source);
+    if (!compiled)
+      return ErrorCode::InvalidValue;
+    formula = std::make_shared<const Formula>(std::move(*compiled));
+  }
+  switch (kind) {
+    case ItemKind::Weapon:
+      return setItemEffect<Weapon>(owner, itemName, std::move(formula));
+    case ItemKind::Potion:
+      return setItemEffect<Potion>(owner, itemName, std::move(formula));
+    case ItemKind::Spell:
+      return setItemEffect<Spell>(owner, itemName, std::move(formula));
+  }
+  return ErrorCode::InvalidValue;
+}
+template <PhysicalDerived T>
+ErrorCode GameSession::useItem(uint32_t user, uint32_t target, std::string_view itemName) {
+  ContainerWithMaxCapacity<T>& container = containerOf<T>(user);
+  std::optional<T> item = Name::fits(itemName) ? container.find(Name(itemName)) : std::nullopt;
+  if (!item)
+    return ErrorCode::ItemNotFound;
+  if (ErrorCode error = item->use(world.characters[user], world.characters[target]); error != ErrorCode::Ok)
+    return error;
+  if constexpr (!std::is_same_v<T, Weapon>)
+    container.remove(item->getName());
+  return ErrorCode::Ok;
+}
+ErrorCode GameSession::use(ItemKind kind, uint32_t user, uint32_t target, std::string_view itemName) {
+  if (!isValid(user) || !isValid(target))
+    return ErrorCode::InvalidHandle;
+  threadRandom().seek(world.randomSeed, commandCount++);
+  switch (kind) {
+    case ItemKind::Weapon:
+      return useItem<Weapon>(user, target, itemName);
+    case ItemKind::Potion:
+      return useItem<Potion>(user, target, itemName);
+    case ItemKind::Spell:
+      return useItem<Spell>(user, target, itemName);
+  }
+  return ErrorCode::InvalidValue;
+}
+ErrorCode GameSession::health(uint32_t handle, int& healthPoints) const {
+  if (!isValid(handle))
+    return ErrorCode::InvalidHandle;
+  healthPoints = world.characters[handle].getHP();
+  return ErrorCode::Ok;
+}
+// Fills as many entries as fit and returns the full item count, so a caller
+// can detect a short buffer without a second query.
+template <PhysicalDerived T>
+size_t GameSession::listItems(uint32_t handle, std::span<InventoryEntry> entries, size_t first) const {
+  const ContainerWithMaxCapacity<T>& container = containerOf<T>(handle);
+  size_t index = 0;
+  for (const auto& [name, item] : container) {
+    if (index >= first && index - first < entries.size()) {
+      InventoryEntry& entry = entries[index - first];
+      entry.name = name.data();
+      entry.nameLength = static_cast<uint32_t>(name.size());
+      if constexpr (std::is_same_v<T, Weapon>)
+        entry.value = item.getDamage();
+      else if constexpr (std::is_same_v<T, Potion>)
+        entry.value = item.getHealValue();
+      else
+        entry.value = static_cast<int32_t>(item.getNumAllowedTargets());
+    }
+    ++index;
+  }
+  return container.size();
+}
+// Fills entries with the items from position first on, in name order, and
+// returns the total number of items.
+size_t GameSession::inventory(uint32_t handle, ItemKind kind, std::span<InventoryEntry> entries, size_t first) const {
+  if (!isValid(handle))
+    return 0;
+  switch (kind) {
+    case ItemKind::Weapon:
+      return listItems<Weapon>(handle, entries, first);
+    case ItemKind::Potion:
+      return listItems<Potion>(handle, entries, first);
+    case ItemKind::Spell:
+      return listItems<Spell>(handle, entries, first);
+  }
+  return 0;
+}
+const World& GameSession::getWorld() const {
+  return world;
+}
@@ -0,0 +1,202 @@
+#include "game/item.h"
+#include "game/alloc_profile.h"
+#include "game/cycle_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+
+PhysicalItem::PhysicalItem()
+    : prototype(ItemCatalog::shared().intern({})),
+      ownerName(ItemCatalog::shared().internName({})),
+      observer(nullptr),
+      isUsableOnce(false),
+      isUsed(false) {}
+PhysicalItem::PhysicalItem(const Character& ch, const ItemPrototype* prototype, bool isUsableOnce)
+    : prototype(prototype),
+      ownerName(ItemCatalog::shared().internName(ch.getName())),
+      observer(nullptr),
+      isUsableOnce(isUsableOnce),
+      isUsed(false) {}
+const ItemPrototype& PhysicalItem::getPrototype() const {
+  return *prototype;
+}
+const Name& PhysicalItem::getName() const {
+  return prototype->name;
+}
+const Name& PhysicalItem::getOwnerName() const {
+  return *ownerName;
+}
+bool PhysicalItem::wasUsed() const {
+  return isUsed;
+}
+// Restores consumption state, e.g. from a snapshot; it notifies nobody.
+void PhysicalItem::setUsed(bool used) {
+  isUsed = used;
+}
+const Formula* PhysicalItem::getEffect() const {
+  return prototype->effect.get();
+}
+void PhysicalItem::setObserver(ContainerObserver* containerObserver) {
+  observer = containerObserver;
+}
+// The formula is part of the definition, so this moves the item to the
+// prototype that differs from its current one only in the effect.
+void PhysicalItem::setEffect(std::shared_ptr<const Formula> formula) {
+  ItemPrototype changed = *prototype;
+  changed.effect = std::move(formula);
+  prototype = ItemCatalog::shared().intern(changed);
+}
+ErrorCode PhysicalItem::useCondition(const Character& user, const Character&) const {
+  if (user.getName() != *ownerName)
+    return ErrorCode::NotOwner;
+  if (isUsableOnce && isUsed)
+    return ErrorCode::ItemUsed;
+  return ErrorCode::Ok;
+}
+void PhysicalItem::giveDamageTo(Character &target, int damage) {
+  target.takeDamage(damage);
+}
+void PhysicalItem::giveHealTo(Character &target, int healVolume) {
+  target.heal(healVolume);
+}
+// Items without a formula keep the fixed value, so the common path costs a
+// single null check. HP is read and the generator looked up only for
+// formulas that use them. Formula results are clamped to a non-negative int.
+int PhysicalItem::effectValue(const Character& user, const Character& target, int base) const {
+  const Formula* effect = prototype->effect.get();
+  if (effect == nullptr)
+    return base;
+  bool health = effect->readsHealth();
+  int64_t value = effect->evaluate(base, health ? user.getHP() : 0, health ? target.getHP() : 0,
+                                   effect->rolls() ? &threadRandom() : nullptr);
+  return static_cast<int>(std::clamp<int64_t>(value, 0, INT32_MAX));
+}
+void PhysicalItem::afterUse() {
+  if (!isUsableOnce)
+    return;
+  isUsed = true;
+  if (observer != nullptr)
+    observer->onItemConsumed(*this);
+}
+ErrorCode PhysicalItem::use(const Character& user, Character& target) {
+  if (ErrorCode error = useCondition(user, target); error != ErrorCode::Ok)
+    return error;
+  if (ErrorCode error = useLogic(user, target); error != ErrorCode::Ok)
+    return error;
+  afterUse();
+  return ErrorCode::Ok;
+}
+std::ostream& operator<<(std::ostream& out, const PhysicalItem& item) {
+  return item.print(out);
+}
+
+Weapon::Weapon(const Character& owner, const Name& name, int damage)
+    : PhysicalItem(owner, ItemCatalog::shared().intern({name, damage, {}, nullptr})) {}
+Weapon::Weapon(const Character& owner, const ItemPrototype* prototype) : PhysicalItem(owner, prototype) {}
+int Weapon::getDamage() const {
+  return getPrototype().value;
+}
+ErrorCode Weapon::setup() const {
+  return getDamage() > 0 ? ErrorCode::Ok : ErrorCode::InvalidValue;
+}
+ErrorCode Weapon::useLogic(const Character& user, Character& target) {
+  ProfileScope scope(ProfileSlot::WeaponUse);
+  giveDamageTo(target, effectValue(user, target, getDamage()));
+  return ErrorCode::Ok;
+}
+std::ostream& Weapon::print(std::ostream& out) const {
+  return out << *this;
+}
+std::ostream& operator<<(std::ostream& out, const Weapon& weapon) {
+  return out << weapon.getName() << ":" << weapon.getDamage();
+}
+
+Potion::Potion(const Character& owner, const Name& name, int healValue)
+    : PhysicalItem(owner, ItemCatalog::shared().intern({name, healValue, {}, nullptr}), true) {}
+Potion::Potion(const Character& owner, const ItemPrototype* prototype) : PhysicalItem(owner, prototype, true) {}
+int Potion::getHealValue() const {
+  return getPrototype().value;
+}
+ErrorCode Potion::setup() const {
+  return getHealValue() > 0 ? ErrorCode::Ok : ErrorCode::InvalidValue;
+}
+ErrorCode Potion::useLogic(const Character& user, Character& target) {
+  ProfileScope scope(ProfileSlot::PotionUse);
+  giveHealTo(target, effectValue(user, target, getHealValue()));
+  return ErrorCode::Ok;
+}
+std::ostream& Potion::print(std::ostream& out) const {
+  return out << *this;
+}
+std::ostream& operator<<(std::ostream& out, const Potion& potion) {
+  return out << potion.getName() << ":" << potion.getHealValue();
+}
+
+namespace {
+
+std::vector<Name> namesOf(const std::vector<Character>& characters) {
+  AllocationTag tag("Spell::allowedTargets");
+  std::vector<Name> names;
+  names.reserve(characters.size());
+  for (const Character& character : characters)
+    names.push_back(character.getName());
+  return names;
+}
+
+}  // namespace
+
+Spell::Spell(const Character& owner, const Name& name, const std::vector<Character>& allowedTargets)
+    : PhysicalItem(owner, ItemCatalog::shared().intern({name, 0, namesOf(allowedTargets), nullptr}), true) {}
+Spell::Spell(const Character& owner, const ItemPrototype* prototype) : PhysicalItem(owner, prototype, true) {}
+size_t Spell::getNumAllowedTargets() const {
+  return getPrototype().allowedTargets.size();
+}
+const std::vector<Name>& Spell::getAllowedTargets() const {
+  return getPrototype().allowedTargets;
+}
+ErrorCode Spell::setup() const {
+  return ErrorCode::Ok;
+}
+ErrorCode Spell::useLogic(const Character& user, Character& target) {
+  ProfileScope scope(ProfileSlot::SpellUse);
+  for (const Name& allowed : getAllowedTargets()) {
+    if (allowed == target.getName()) {
+      giveDamageTo(target, effectValue(user, target, target.getHP()));
+      return ErrorCode::Ok;
+    }
+  }
+  return ErrorCode::InvalidTarget;
+}
+std::ostream& Spell::print(std::ostream& out) const {
+  return out << *this;
+}
+std::ostream& operator<<(std::ostream& out, const Spell& spell) {
+  return out << spell.getName() << ":" << spell.getNumAllowedTargets();
+}
+
+void benchmarkEffects(size_t uses, std::ostream& report) {
+  constexpr const char* formulas[] = {nullptr, "base", "base + target_hp / 1000000000", "max(1, base + roll(6) - 3)"};
+  Character user(Name("user"), 1000);
+  for (const char* source : formulas) {
+    Weapon weapon(user, Name("blade"), 5);
+    if (source != nullptr)
+      weapon.setEffect(std::make_shared<const Formula>(*Formula::compile(source)));
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+      Character target(Name("target"), 1000000000);
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < uses; ++i) {
+        threadRandom().seek(1, i);
+        weapon.use(user, target);
+      }
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      double perUse = elapsed.count() / static_cast<double>(uses);
+      if (run == 0 || perUse < best)
+        best = perUse;
+    }
+    report << std::left << std::setw(32) << (source != nullptr ? source : "fixed damage") << std::fixed
+           << std::setprecision(1) << best << " ns/use\n";
+  }
+}
@@ -0,0 +1,61 @@
+#include "game/item_catalog.h"
+#include "game/alloc_profile.h"
+
+#include <functional>
+
+bool ItemPrototype::operator==(const ItemPrototype& other) const {
+  return name == other.name && value == other.value && allowedTargets == other.allowedTargets &&
+         effect == other.effect;
+}
+
+size_t ItemCatalog::Hash::operator()(const ItemPrototype* prototype) const {
+  size_t hash = prototype->name.hash() ^ std::hash<int>{}(prototype->value) * 0x9E3779B97F4A7C15ull;
+  for (const Name& target : prototype->allowedTargets)
+    hash = hash * 31 + target.hash();
+  return hash ^ std::hash<const Formula*>{}(prototype->effect.get());
+}
+size_t ItemCatalog::Hash::operator()(const Name* name) const {
+  return name->hash();
+}
+size_t ItemCatalog::Hash::operator()(const Name& name) const {
+  return name.hash();
+}
+bool ItemCatalog::Equal::operator()(const ItemPrototype* a, const ItemPrototype* b) const {
+  return *a == *b;
+}
+bool ItemCatalog::Equal::operator()(const Name* a, const Name* b) const {
+  return *a == *b;
+}
+bool ItemCatalog::Equal::operator()(const Name* a, const Name& b) const {
+  return *a == b;
+}
+bool ItemCatalog::Equal::operator()(const Name& a, const Name* b) const {
+  return a == *b;
+}
+
+ItemCatalog& ItemCatalog::shared() {
+  static ItemCatalog catalog;
+  return catalog;
+}
+const ItemPrototype* ItemCatalog::intern(const ItemPrototype& prototype) {
+  AllocationTag tag("ItemCatalog::intern");
+  std::lock_guard lock(mutex);
+  if (auto found = prototypeIndex.find(&prototype); found != prototypeIndex.end())
+    return *found;
+  const ItemPrototype* stored = &prototypes.emplace_back(prototype);
+  prototypeIndex.insert(stored);
+  return stored;
+}
+const Name* ItemCatalog::internName(const Name& name) {
+  AllocationTag tag("ItemCatalog::internName");
+  std::lock_guard lock(mutex);
+  if (auto found = nameIndex.find(name); found != nameIndex.end())
+    return *found;
+  const Name* stored = &names.emplace_back(name);
+  nameIndex.insert(stored);
+  return stored;
+}
+size_t ItemCatalog::size() const {
+  std::lock_guard lock(mutex);
+  return prototypes.size();
+}
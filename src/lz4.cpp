@@ -0,0 +1,264 @@
+#include "game/lz4.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace lz4 {
+
+namespace {
+
+constexpr size_t minMatch = 4;
+// The format requires the last 5 bytes of a block to be literals and the
+// last match to start at least 12 bytes before the end.
+constexpr size_t lastLiterals = 5;
+constexpr size_t matchSafeDistance = 12;
+constexpr unsigned hashBits = 16;
+constexpr size_t wildCopy = 16;
+constexpr uint32_t uncompressedFlag = 0x80000000u;
+constexpr uint8_t frameFlags = 0x60;       // version 01, independent blocks, no checksums
+constexpr uint8_t frameBlockMaxId = 0x70;  // 4 MiB blocks
+
+uint32_t read32(const void* source) {
+  uint32_t value;
+  std::memcpy(&value, source, sizeof(value));
+  return value;
+}
+void write32(std::ostream& out, uint32_t value) {
+  char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16),
+                   static_cast<char>(value >> 24)};
+  out.write(bytes, sizeof(bytes));
+}
+uint32_t hashOf(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - hashBits);
+}
+char* writeLength(char* out, size_t length) {
+  for (; length >= 255; length -= 255)
+    *out++ = static_cast<char>(255);
+  *out++ = static_cast<char>(length);
+  return out;
+}
+char* writeLiterals(char* out, char* token, const char* literals, size_t count) {
+  *token = static_cast<char>(std::min<size_t>(count, 15) << 4);
+  if (count >= 15)
+    out = writeLength(out, count - 15);
+  std::memcpy(out, literals, count);
+  return out + count;
+}
+bool readLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+  uint8_t byte;
+  do {
+    if (in == end)
+      return false;
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+uint32_t xxh32(const void* data, size_t length, uint32_t seed) {
+  constexpr uint32_t prime1 = 2654435761u, prime2 = 2246822519u, prime3 = 3266489917u, prime4 = 668265263u,
+                     prime5 = 374761393u;
+  const auto* in = static_cast<const uint8_t*>(data);
+  const uint8_t* end = in + length;
+  uint32_t hash;
+  if (length >= 16) {
+    std::array<uint32_t, 4> lanes = {seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+    for (; in + 16 <= end; in += 16)
+      for (size_t lane = 0; lane < 4; ++lane)
+        lanes[lane] = std::rotl(lanes[lane] + read32(in + 4 * lane) * prime2, 13) * prime1;
+    hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+  } else {
+    hash = seed + prime5;
+  }
+  hash += static_cast<uint32_t>(length);
+  for (; in + 4 <= end; in += 4)
+    hash = std::rotl(hash + read32(in) * prime3, 17) * prime4;
+  for (; in < end; ++in)
+    hash = std::rotl(hash + *in * prime5, 11) * prime1;
+  hash ^= hash >> 15;
+  hash *= prime2;
+  hash ^= hash >> 13;
+  hash *= prime3;
+  return hash ^ hash >> 16;
+}
+
+size_t compressBound(size_t size) {
+  return size + size / 255 + 16;
+}
+// Greedy single-probe matcher over a 64 Ki-entry table of 4-byte prefixes.
+// The step grows while no match is found, so incompressible data passes
+// through quickly.
+size_t compressBlock(const char* source, size_t size, char* destination) {
+  char* out = destination;
+  size_t anchor = 0;
+  if (size > matchSafeDistance) {
+    std::vector<uint32_t> table(size_t{1} << hashBits, 0);
+    size_t limit = size - matchSafeDistance;
+    size_t matchLimit = size - lastLiterals;
+    size_t position = 0;
+    size_t misses = 0;
+    while (position < limit) {
+      uint32_t sequence = read32(source + position);
+      uint32_t& slot = table[hashOf(sequence)];
+      size_t candidate = slot;
+      slot = static_cast<uint32_t>(position + 1);
+      if (candidate == 0 || position + 1 - candidate > 65535 || read32(source + candidate - 1) != sequence) {
+        position += 1 + (misses++ >> 6);
+        continue;
+      }
+      misses = 0;
+      size_t match = candidate - 1;
+      size_t length = minMatch;
+      while (position + length < matchLimit && source[match + length] == source[position + length])
+        ++length;
+      char* token = out++;
+      out = writeLiterals(out, token, source + anchor, position - anchor);
+      size_t offset = position - match;
+      *out++ = static_cast<char>(offset);
+      *out++ = static_cast<char>(offset >> 8);
+      size_t code = length - minMatch;
+      *token = static_cast<char>(*token | std::min<size_t>(code, 15));
+      if (code >= 15)
+        out = writeLength(out, code - 15);
+      position += length;
+      anchor = position;
+    }
+  }
+  char* token = out++;
+  out = writeLiterals(out, token, source + anchor, size - anchor);
+  return static_cast<size_t>(out - destination);
+}
+// Checks every length and offset against both buffers, so corrupt input
+// fails instead of reading or writing out of bounds. Short literal runs and
+// matches at least 16 bytes back are copied in whole 16-byte chunks when
+// both buffers have the slack; bytes past the run are overwritten later.
+std::optional<size_t> decompressBlock(const char* source, size_t size, char* destination, size_t capacity) {
+  const auto* in = reinterpret_cast<const uint8_t*>(source);
+  const uint8_t* end = in + size;
+  char* out = destination;
+  char* outEnd = destination + capacity;
+  while (in < end) {
+    uint8_t token = *in++;
+    size_t literals = token >> 4;
+    if (literals == 15 && !readLength(in, end, literals))
+      return std::nullopt;
+    if (literals > static_cast<size_t>(end - in) || literals > static_cast<size_t>(outEnd - out))
+      return std::nullopt;
+    if (literals <= wildCopy && static_cast<size_t>(end - in) >= wildCopy &&
+        static_cast<size_t>(outEnd - out) >= wildCopy)
+      std::memcpy(out, in, wildCopy);
+    else
+      std::memcpy(out, in, literals);
+    in += literals;
+    out += literals;
+    if (in == end)
+      return static_cast<size_t>(out - destination);
+    if (end - in < 2)
+      return std::nullopt;
+    size_t offset = in[0] | static_cast<size_t>(in[1]) << 8;
+    in += 2;
+    size_t length = token & 15;
+    if (length == 15 && !readLength(in, end, length))
+      return std::nullopt;
+    length += minMatch;
+    if (offset == 0 || offset > static_cast<size_t>(out - destination) ||
+        length > static_cast<size_t>(outEnd - out))
+      return std::nullopt;
+    const char* match = out - offset;
+    if (offset >= wildCopy && static_cast<size_t>(outEnd - out) >= length + wildCopy) {
+      for (size_t copied = 0; copied < length; copied += wildCopy)
+        std::memcpy(out + copied, match + copied, wildCopy);
+      out += length;
+    } else if (offset >= length) {
+      std::memcpy(out, match, length);
+      out += length;
+    } else {
+      for (size_t i = 0; i < length; ++i)
+        *out++ = match[i];
+    }
+  }
+  return std::nullopt;
+}
+
+bool isFrame(std::string_view data) {
+  return data.size() >= 4 && read32(data.data()) == frameMagic;
+}
+std::vector<Block> frameBlocks(std::string_view data) {
+  std::vector<Block> blocks;
+  size_t position = 0;
+  auto need = [&](size_t bytes) {
+    if (data.size() - position < bytes)
+      throw std::runtime_error("Error caught");
+  };
+  while (position < data.size()) {
+    need(4);
+    uint32_t magic = read32(data.data() + position);
+    if ((magic & 0xFFFFFFF0u) == 0x184D2A50u) {
+      need(8);
+      uint64_t skipped = read32(data.data() + position + 4);
+      position += 8;
+      need(skipped);
+      position += skipped;
+      continue;
+    }
+    need(7);
+    uint8_t flags = static_cast<uint8_t>(data[position + 4]);
+    if (magic != frameMagic || flags >> 6 != 1 || (flags & 0x20) == 0)
+      throw std::runtime_error("Error caught");
+    bool blockChecksums = flags & 0x10;
+    size_t descriptor = 2 + (flags & 0x08 ? 8 : 0) + (flags & 0x01 ? 4 : 0);
+    need(4 + descriptor + 1);
+    uint8_t headerChecksum = static_cast<uint8_t>(data[position + 4 + descriptor]);
+    if (((xxh32(data.data() + position + 4, descriptor) >> 8) & 0xFF) != headerChecksum)
+      throw std::runtime_error("Error caught");
+    position += 4 + descriptor + 1;
+    for (;;) {
+      need(4);
+      uint32_t header = read32(data.data() + position);
+      position += 4;
+      if (header == 0)
+        break;
+      uint32_t size = header & ~uncompressedFlag;
+      if (size > maxBlockSize)
+        throw std::runtime_error("Error caught");
+      need(size + (blockChecksums ? 4 : 0));
+      blocks.push_back({data.data() + position, size, (header & uncompressedFlag) == 0});
+      position += size + (blockChecksums ? 4 : 0);
+    }
+    if (flags & 0x04) {
+      need(4);
+      position += 4;
+    }
+  }
+  return blocks;
+}
+void writeFrameHeader(std::ostream& out) {
+  const char descriptor[2] = {static_cast<char>(frameFlags), static_cast<char>(frameBlockMaxId)};
+  write32(out, frameMagic);
+  out.write(descriptor, sizeof(descriptor));
+  out.put(static_cast<char>((xxh32(descriptor, sizeof(descriptor)) >> 8) & 0xFF));
+}
+// Stores the block raw when compression would not make it smaller. Returns
+// the bytes written, block header included.
+size_t writeBlock(std::ostream& out, const char* data, size_t size, std::string& scratch) {
+  scratch.resize(compressBound(size));
+  size_t compressed = compressBlock(data, size, scratch.data());
+  if (compressed >= size) {
+    write32(out, static_cast<uint32_t>(size) | uncompressedFlag);
+    out.write(data, static_cast<std::streamsize>(size));
+    return 4 + size;
+  }
+  write32(out, static_cast<uint32_t>(compressed));
+  out.write(scratch.data(), static_cast<std::streamsize>(compressed));
+  return 4 + compressed;
+}
+void writeFrameEnd(std::ostream& out) {
+  write32(out, 0);
+}
+
+}  // namespace lz4
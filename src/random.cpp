@@ -0,0 +1,134 @@
+#include "game/random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t multiplier0 = 0xD2511F53;
+constexpr uint32_t multiplier1 = 0xCD9E8D57;
+constexpr uint32_t weyl0 = 0x9E3779B9;
+constexpr uint32_t weyl1 = 0xBB67AE85;
+constexpr int rounds = 10;
+
+// One Philox4x32-10 block: the counter is the block number and the stream.
+inline std::array<uint32_t, 4> philox(uint64_t counter, uint64_t stream, std::array<uint32_t, 2> key) {
+  uint32_t c0 = static_cast<uint32_t>(counter);
+  uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+  uint32_t c2 = static_cast<uint32_t>(stream);
+  uint32_t c3 = static_cast<uint32_t>(stream >> 32);
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (int round = 0; round < rounds; ++round) {
+    uint64_t product0 = static_cast<uint64_t>(multiplier0) * c0;
+    uint64_t product1 = static_cast<uint64_t>(multiplier1) * c2;
+    c0 = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ k0;
+    c2 = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ k1;
+    c1 = static_cast<uint32_t>(product1);
+    c3 = static_cast<uint32_t>(product0);
+    k0 += weyl0;
+    k1 += weyl1;
+  }
+  return {c0, c1, c2, c3};
+}
+
+}  // namespace
+
+CombatRandom::CombatRandom(uint64_t seed, uint64_t stream)
+    : key(), stream(0), block(0), buffer(), position(0), filled(0) {
+  seek(seed, stream);
+}
+// Cheap enough to call per command: nothing is generated until the first
+// draw after a seek.
+void CombatRandom::seek(uint64_t seed, uint64_t newStream) {
+  key = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+  stream = newStream;
+  block = 0;
+  position = 0;
+  filled = 0;
+}
+void CombatRandom::refillBlock() {
+  std::array<uint32_t, 4> values = philox(block++, stream, key);
+  std::copy(values.begin(), values.end(), buffer.begin());
+  position = 0;
+  filled = values.size();
+}
+// Each block is independent and the round loop has a fixed trip count, so
+// the compiler can unroll the rounds and run several blocks per vector.
+void CombatRandom::refillBatch() {
+  for (size_t i = 0; i < blocksPerBatch; ++i) {
+    std::array<uint32_t, 4> values = philox(block + i, stream, key);
+    std::copy(values.begin(), values.end(), buffer.begin() + static_cast<std::ptrdiff_t>(4 * i));
+  }
+  block += blocksPerBatch;
+  position = 0;
+  filled = buffer.size();
+}
+uint32_t CombatRandom::next() {
+  if (position == filled)
+    refillBlock();
+  return buffer[position++];
+}
+// Uniform in [0, bound) by multiply-shift; the bias is below 2^-32 * bound,
+// far under anything a combat roll can show.
+uint32_t CombatRandom::below(uint32_t bound) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+}
+bool CombatRandom::chance(uint32_t percent) {
+  return below(100) < percent;
+}
+void CombatRandom::fill(std::span<uint32_t> values) {
+  while (!values.empty()) {
+    if (position == filled)
+      refillBatch();
+    size_t count = std::min(values.size(), filled - position);
+    std::copy_n(buffer.begin() + static_cast<std::ptrdiff_t>(position), count, values.begin());
+    position += count;
+    values = values.subspan(count);
+  }
+}
+CombatRandom& threadRandom() {
+  thread_local CombatRandom random;
+  return random;
+}
+
+void benchmarkRandom(size_t values, size_t valuesPerSeek, std::ostream& report) {
+  valuesPerSeek = std::max<size_t>(valuesPerSeek, 1);
+  auto measure = [&](auto draw) {
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0, sequence = 0; done < values; done += valuesPerSeek, ++sequence)
+      checksum += draw(sequence);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return std::pair(elapsed.count() / static_cast<double>(values), checksum);
+  };
+  CombatRandom random;
+  std::vector<uint32_t> buffer(valuesPerSeek);
+  auto [next, nextChecksum] = measure([&](uint64_t sequence) {
+    random.seek(1, sequence);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < valuesPerSeek; ++i)
+      sum += random.next();
+    return sum;
+  });
+  auto [fill, fillChecksum] = measure([&](uint64_t sequence) {
+    random.seek(1, sequence);
+    random.fill(buffer);
+    return std::accumulate(buffer.begin(), buffer.end(), uint64_t{0});
+  });
+  std::mt19937 twister(1);
+  auto [mt, mtChecksum] = measure([&](uint64_t) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < valuesPerSeek; ++i)
+      sum += twister();
+    return sum;
+  });
+  report << "CombatRandom::next: " << next << " ns/value\nCombatRandom::fill: " << fill
+         << " ns/value\nstd::mt19937:       " << mt << " ns/value\n";
+  if (nextChecksum != fillChecksum)
+    report << "next and fill disagree\n";
+  (void)mtChecksum;
+}
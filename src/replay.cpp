@@ -0,0 +1,247 @@
+#include "game/replay.h"
+#include "game/command.h"
+#include "game/command_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+GoldenComparator::GoldenComparator(std::istream& golden, size_t chunkSize)
+    : golden(golden), actual(std::max<size_t>(chunkSize, 1)), expected(actual.size()), flushed(0), compared(0), matchedLines(0) {
+  setp(actual.data(), actual.data() + actual.size());
+}
+void GoldenComparator::compareChunk() {
+  size_t pending = static_cast<size_t>(pptr() - pbase());
+  setp(actual.data(), actual.data() + actual.size());
+  flushed += pending;
+  if (divergence || pending == 0)
+    return;
+  golden.read(expected.data(), static_cast<std::streamsize>(pending));
+  size_t available = static_cast<size_t>(golden.gcount());
+  size_t common = std::min(pending, available);
+  if (available == pending && std::memcmp(actual.data(), expected.data(), pending) == 0) {
+    matchedLines += static_cast<uint64_t>(std::count(actual.data(), actual.data() + pending, '\n'));
+    compared += pending;
+    return;
+  }
+  size_t first = static_cast<size_t>(std::mismatch(actual.data(), actual.data() + common, expected.data()).first -
+                                     actual.data());
+  matchedLines += static_cast<uint64_t>(std::count(actual.data(), actual.data() + first, '\n'));
+  compared += first;
+  divergence = compared;
+}
+GoldenComparator::int_type GoldenComparator::overflow(int_type character) {
+  compareChunk();
+  if (!traits_type::eq_int_type(character, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(character);
+    pbump(1);
+  }
+  return traits_type::not_eof(character);
+}
+uint64_t GoldenComparator::written() const {
+  return flushed + static_cast<uint64_t>(pptr() - pbase());
+}
+uint64_t GoldenComparator::getCompared() const {
+  return compared;
+}
+bool GoldenComparator::diverged() const {
+  return divergence.has_value();
+}
+// Compares what is still buffered, then checks that the golden output has
+// nothing left over.
+bool GoldenComparator::finish() {
+  compareChunk();
+  if (!divergence && golden.peek() != std::istream::traits_type::eof())
+    divergence = compared;
+  return !divergence;
+}
+std::optional<uint64_t> GoldenComparator::getDivergence() const {
+  return divergence;
+}
+uint64_t GoldenComparator::getMatchedLines() const {
+  return matchedLines;
+}
+
+namespace {
+
+template <PhysicalDerived T>
+void describeItems(std::ostream& out, const char* label, const ContainerWithMaxCapacity<T>& container) {
+  out << "    " << label << " (" << container.size() << '/' << container.getMaxCapacity() << "):";
+  for (const auto& [name, item] : container)
+    out << ' ' << item;
+  out << '\n';
+}
+void describeCharacter(std::ostream& out, const World& world, uint32_t handle) {
+  out << "  [" << handle << "] " << world.characters[handle] << '\n';
+  describeItems(out, "arsenal", world.arsenals[handle]);
+  describeItems(out, "medical bag", world.medicalBags[handle]);
+  describeItems(out, "spell book", world.spellBooks[handle]);
+}
+void describeState(std::ostream& out, const World& world, const SessionEvent& event) {
+  describeCharacter(out, world, event.user);
+  if (event.target != event.user)
+    describeCharacter(out, world, event.target);
+}
+// Hands the commands of input, plain or LZ4-compressed, to visit in order
+// with the zero-based number of the line each one is on, through the parser
+// runCommandInput uses. Stops when visit returns false. Returns the number
+// of lines, counting a last line without '\n'.
+uint64_t forEachCommandLine(std::string_view input,
+                            const std::function<bool(const CommandBatch&, const CommandRecord&, uint64_t)>& visit) {
+  uint64_t line = 0;
+  bool openLine = false;
+  forEachInputBatch(input, [&](const CommandBatch& batch) {
+    auto scanned = batch.text.begin();
+    for (const CommandRecord& record : batch.records) {
+      auto start = batch.text.begin() + batch.tokens[record.firstToken - 1].offset;
+      line += static_cast<uint64_t>(std::count(scanned, start, '\n'));
+      scanned = start;
+      if (!visit(batch, record, line))
+        return false;
+    }
+    line += static_cast<uint64_t>(std::count(scanned, batch.text.end(), '\n'));
+    if (!batch.text.empty())
+      openLine = batch.text.back() != '\n';
+    return true;
+  });
+  return line + (openLine ? 1 : 0);
+}
+// The line holding record, without its '\n'.
+std::string_view lineOf(const CommandBatch& batch, const CommandRecord& record) {
+  size_t offset = batch.tokens[record.firstToken - 1].offset;
+  size_t start = batch.text.rfind('\n', offset);
+  start = start == std::string_view::npos ? 0 : start + 1;
+  size_t end = std::min(batch.text.find('\n', offset), batch.text.size());
+  return batch.text.substr(start, end - start);
+}
+std::string expectedOutput(std::istream& golden, uint64_t start, const std::string& actualText) {
+  std::string expectedText;
+  golden.clear();
+  golden.seekg(static_cast<std::streamoff>(start));
+  auto expectedLines = std::max<std::ptrdiff_t>(1, std::count(actualText.begin(), actualText.end(), '\n'));
+  for (std::string line; expectedLines > 0 && std::getline(golden, line); --expectedLines)
+    expectedText += line + '\n';
+  return expectedText;
+}
+void writeIndented(std::ostream& out, const char* label, const std::string& text) {
+  std::istringstream lines(text);
+  std::string line;
+  out << label << '\n';
+  while (std::getline(lines, line))
+    out << "  | " << line << '\n';
+}
+
+}  // namespace
+
+ReplayReport verifyReplay(const World& initial, const std::vector<SessionEvent>& events, std::istream& golden,
+                          std::ostream& report, size_t chunkSize) {
+  World world = initial;
+  GoldenComparator comparator(golden, chunkSize);
+  std::ostream out(&comparator);
+  // Start offsets of the events whose output has not been fully compared
+  // yet; comparison lags by at most one chunk, so this stays short.
+  std::deque<std::pair<uint64_t, size_t>> starts;
+  for (size_t index = 0; index < events.size() && !comparator.diverged(); ++index) {
+    starts.emplace_back(comparator.written(), index);
+    runEvent(world, events[index], out);
+    while (starts.size() > 1 && starts[1].first <= comparator.getCompared())
+      starts.pop_front();
+  }
+  if (comparator.finish()) {
+    report << "Output matches: " << events.size() << " events, " << comparator.getCompared() << " bytes\n";
+    return {true, comparator.getCompared(), comparator.getMatchedLines(), std::nullopt};
+  }
+
+  uint64_t offset = *comparator.getDivergence();
+  ReplayReport result{false, offset, comparator.getMatchedLines() + 1, std::nullopt};
+  report << "Output diverges at byte " << offset << ", line " << result.line << '\n';
+  if (offset == comparator.written()) {
+    report << "The actual output ends here, but the golden output continues\n";
+    return result;
+  }
+  auto containing = std::find_if(starts.rbegin(), starts.rend(), [&](const auto& start) { return start.first <= offset; });
+  size_t index = containing->second;
+  uint64_t eventStart = containing->first;
+  const SessionEvent& event = events[index];
+  result.eventIndex = index;
+
+  World replayed = initial;
+  std::ostringstream discard;
+  for (size_t i = 0; i < index; ++i) {
+    runEvent(replayed, events[i], discard);
+    discard.str({});
+  }
+  std::ostringstream before;
+  describeState(before, replayed, event);
+  std::ostringstream actualOutput;
+  runEvent(replayed, event, actualOutput);
+  std::string actualText = actualOutput.str();
+
+  std::string expectedText = expectedOutput(golden, eventStart, actualText);
+
+  report << "In event " << index << " (sequence " << event.sequence << "): character " << event.user
+         << " uses item \"" << event.item << "\" on character " << event.target << '\n';
+  writeIndented(report, "Expected:", expectedText);
+  writeIndented(report, "Actual:", actualText);
+  report << "Before the event:\n" << before.str() << "After the event:\n";
+  describeState(report, replayed, event);
+  return result;
+}
+ReplayReport verifyCommandReplay(std::string_view input, std::istream& golden, std::ostream& report,
+                                 size_t chunkSize) {
+  GoldenComparator comparator(golden, chunkSize);
+  std::ostream out(&comparator);
+  std::deque<std::pair<uint64_t, uint64_t>> starts;
+  uint64_t lines = 0;
+  {
+    World world;
+    CommandInterpreter interpreter(world, out);
+    lines = forEachCommandLine(input, [&](const CommandBatch& batch, const CommandRecord& record, uint64_t line) {
+      starts.emplace_back(comparator.written(), line);
+      interpreter.execute(batch, record);
+      while (starts.size() > 1 && starts[1].first <= comparator.getCompared())
+        starts.pop_front();
+      return !comparator.diverged();
+    });
+  }
+  if (comparator.finish()) {
+    report << "Output matches: " << lines << " commands, " << comparator.getCompared() << " bytes\n";
+    return {true, comparator.getCompared(), comparator.getMatchedLines(), std::nullopt};
+  }
+
+  uint64_t offset = *comparator.getDivergence();
+  ReplayReport result{false, offset, comparator.getMatchedLines() + 1, std::nullopt};
+  report << "Output diverges at byte " << offset << ", line " << result.line << '\n';
+  if (offset == comparator.written()) {
+    report << "The actual output ends here, but the golden output continues\n";
+    return result;
+  }
+  auto containing = std::find_if(starts.rbegin(), starts.rend(), [&](const auto& start) { return start.first <= offset; });
+  uint64_t index = containing->second;
+  result.eventIndex = static_cast<size_t>(index);
+
+  World replayed;
+  std::ostringstream replayOutput;
+  std::string command;
+  {
+    CommandInterpreter interpreter(replayed, replayOutput);
+    forEachCommandLine(input, [&](const CommandBatch& batch, const CommandRecord& record, uint64_t line) {
+      if (line == index)
+        command = lineOf(batch, record);
+      replayOutput.str({});
+      interpreter.execute(batch, record);
+      return line < index;
+    });
+  }
+  std::string actualText = replayOutput.str();
+  std::string expectedText = expectedOutput(golden, containing->first, actualText);
+
+  report << "In command line " << index + 1 << ": " << command << '\n';
+  writeIndented(report, "Expected:", expectedText);
+  writeIndented(report, "Actual:", actualText);
+  return result;
+}
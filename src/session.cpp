@@ -0,0 +1,84 @@
+#include "game/session.h"
+#include "game/random.h"
+
+#include <optional>
+#include <random>
+
+template <PhysicalDerived T>
+void writeUse(std::ostream& out, const Character& user, const Character& target, const std::string& itemName) {
+  if constexpr (std::is_same_v<T, Weapon>)
+    out << user.getName() << " attacks " << target.getName() << " with their " << itemName << "!\n";
+  else if constexpr (std::is_same_v<T, Potion>)
+    out << target.getName() << " drinks " << itemName << " from " << user.getName() << ".\n";
+  else
+    out << user.getName() << " casts " << itemName << " on " << target.getName() << "!\n";
+}
+template void writeUse<Weapon>(std::ostream&, const Character&, const Character&, const std::string&);
+template void writeUse<Potion>(std::ostream&, const Character&, const Character&, const std::string&);
+template void writeUse<Spell>(std::ostream&, const Character&, const Character&, const std::string&);
+
+template <PhysicalDerived T>
+void runEvent(World& world, ContainerWithMaxCapacity<T>& container, const SessionEvent& event, std::ostream& out) {
+  Character& target = world.characters[event.target];
+  std::optional<T> item = Name::fits(event.item) ? container.find(Name(event.item)) : std::nullopt;
+  if (!item || item->use(world.characters[event.user], target) != ErrorCode::Ok) {
+    out << "Error caught\n";
+    return;
+  }
+  writeUse<T>(out, world.characters[event.user], target, event.item);
+  if constexpr (!std::is_same_v<T, Weapon>)
+    container.remove(item->getName());
+  if (target.getHP() <= 0)
+    out << target.getName() << " has died...\n";
+}
+void runEvent(World& world, const SessionEvent& event, std::ostream& out) {
+  threadRandom().seek(world.randomSeed, event.sequence);
+  switch (event.kind) {
+    case ItemKind::Weapon:
+      runEvent(world, world.arsenals[event.user], event, out);
+      break;
+    case ItemKind::Potion:
+      runEvent(world, world.medicalBags[event.user], event, out);
+      break;
+    case ItemKind::Spell:
+      runEvent(world, world.spellBooks[event.user], event, out);
+      break;
+  }
+}
+void runSession(World& world, const std::vector<SessionEvent>& events, std::ostream& out) {
+  for (const SessionEvent& event : events)
+    runEvent(world, event, out);
+}
+
+SyntheticSession generateSession(uint32_t characterCount, size_t eventCount, uint64_t seed, uint32_t missingPercent) {
+  constexpr int itemsPerKind = 3;
+  std::mt19937_64 random(seed);
+  SyntheticSession session;
+  World& world = session.world;
+  world.randomSeed = seed;
+  for (uint32_t handle = 0; handle < characterCount; ++handle)
+    world.characters.emplace_back(Name("character" + std::to_string(handle)), 200 + static_cast<int>(random() % 100));
+  world.arsenals.assign(characterCount, ContainerWithMaxCapacity<Weapon>(itemsPerKind));
+  world.medicalBags.assign(characterCount, ContainerWithMaxCapacity<Potion>(itemsPerKind));
+  world.spellBooks.assign(characterCount, ContainerWithMaxCapacity<Spell>(itemsPerKind));
+  for (uint32_t handle = 0; handle < characterCount; ++handle) {
+    const Character& owner = world.characters[handle];
+    for (int i = 0; i < itemsPerKind; ++i) {
+      std::string suffix = std::to_string(i);
+      world.arsenals[handle].add(Weapon(owner, Name("weapon" + suffix), 1 + static_cast<int>(random() % 20)));
+      world.medicalBags[handle].add(Potion(owner, Name("potion" + suffix), 1 + static_cast<int>(random() % 20)));
+      world.spellBooks[handle].add(Spell(owner, Name("spell" + suffix), {world.characters[random() % characterCount]}));
+    }
+  }
+  for (uint64_t sequence = 0; sequence < eventCount; ++sequence) {
+    SessionEvent event{sequence, static_cast<ItemKind>(random() % 3), static_cast<uint32_t>(random() % characterCount),
+                       static_cast<uint32_t>(random() % characterCount), {}};
+    const char* prefix = event.kind == ItemKind::Weapon ? "weapon" : event.kind == ItemKind::Potion ? "potion" : "spell";
+    bool missing = random() % 100 < missingPercent;
+    event.item = prefix + std::to_string(missing ? itemsPerKind : random() % itemsPerKind);
+    if (event.kind == ItemKind::Potion)
+      event.target = event.user;
+    session.events.push_back(std::move(event));
+  }
+  return session;
+}
@@ -0,0 +1,438 @@
+#include "game/shard.h"
+#include "game/command.h"
+#include "game/command_file.h"
+#include "game/random.h"
+#include "game/snapshot.h"
+
+#include <algorithm>
+#include <charconv>
+#include <csignal>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+bool receiveExactly(int fd, char* buffer, size_t length) {
+  for (size_t received = 0; received < length;) {
+    ssize_t count = read(fd, buffer + received, length - received);
+    if (count <= 0)
+      return false;
+    received += static_cast<size_t>(count);
+  }
+  return true;
+}
+// Cuts text up to the next delimiter (or the end) off the front of rest.
+std::string_view cut(std::string_view& rest, char delimiter) {
+  size_t end = std::min(rest.find(delimiter), rest.size());
+  std::string_view piece = rest.substr(0, end);
+  rest.remove_prefix(std::min(end + 1, rest.size()));
+  return piece;
+}
+template <typename T>
+T number(std::string_view word) {
+  T value{};
+  auto [end, error] = std::from_chars(word.data(), word.data() + word.size(), value);
+  if (word.empty() || error != std::errc() || end != word.data() + word.size())
+    throw std::runtime_error("Error caught");
+  return value;
+}
+void applyChange(Character& character, std::string_view tag, std::string_view change) {
+  if (tag == "K") {
+    character.takeDamage(character.getHP());
+    return;
+  }
+  int delta = number<int>(change);
+  if (delta < 0)
+    character.takeDamage(-delta);
+  else
+    character.heal(delta);
+}
+
+// A worker's world holds only its shard, under its own handles, so
+// characters travel by name. Lines of a batch:
+//   D <delta line>                              character or item added
+//   H <name> <hp-change>, K <name>              effect of an earlier use
+//   U <sequence> <kind> <user> <target> <item>  use, answered by one line:
+//                                               E (failed), H <hp-change> or K
+//   S                                           answer with a snapshot instead
+class ShardWorker {
+ private:
+  World world;
+  std::unordered_map<Name, uint32_t> handles;
+  std::string deltas;
+  int fd;
+
+  Character& character(std::string_view);
+  void applyAdded();
+  template <PhysicalDerived T>
+  void useItem(ContainerWithMaxCapacity<T>&, const Character&, std::string_view, std::string_view, std::string&);
+
+ public:
+  explicit ShardWorker(int);
+  void run();
+};
+// The first batch is the shard's snapshot.
+ShardWorker::ShardWorker(int fd) : fd(fd) {
+  std::optional<std::string> snapshot = receiveBatch(fd);
+  if (!snapshot)
+    throw std::runtime_error("Error caught");
+  world = SnapshotView(snapshot->data(), snapshot->size()).restore();
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle)
+    handles.emplace(world.characters[handle].getName(), handle);
+}
+Character& ShardWorker::character(std::string_view name) {
+  auto found = Name::fits(name) ? handles.find(Name(name)) : handles.end();
+  if (found == handles.end())
+    throw std::runtime_error("Error caught");
+  return world.characters[found->second];
+}
+void ShardWorker::applyAdded() {
+  if (deltas.empty())
+    return;
+  uint32_t first = static_cast<uint32_t>(world.characters.size());
+  std::istringstream in(deltas);
+  if (applyDeltas(in, world) != ErrorCode::Ok)
+    throw std::runtime_error("Error caught");
+  for (uint32_t handle = first; handle < world.characters.size(); ++handle)
+    handles.emplace(world.characters[handle].getName(), handle);
+  deltas.clear();
+}
+// The stand-in target starts at 0 HP; only the change is sent back.
+template <PhysicalDerived T>
+void ShardWorker::useItem(ContainerWithMaxCapacity<T>& container, const Character& user, std::string_view targetName,
+                          std::string_view itemName, std::string& reply) {
+  Character target(Name(targetName), 0);
+  std::optional<T> item = Name::fits(itemName) ? container.find(Name(itemName)) : std::nullopt;
+  if (!item || item->use(user, target) != ErrorCode::Ok) {
+    reply += "E\n";
+    return;
+  }
+  if constexpr (std::is_same_v<T, Spell>)
+    reply += "K\n";
+  else
+    reply.append("H ").append(std::to_string(target.getHP())).push_back('\n');
+  if constexpr (!std::is_same_v<T, Weapon>)
+    container.remove(item->getName());
+}
+void ShardWorker::run() {
+  while (std::optional<std::string> batch = receiveBatch(fd)) {
+    std::string reply;
+    bool snapshot = false;
+    for (std::string_view rest = *batch; !rest.empty();) {
+      std::string_view line = cut(rest, '\n');
+      std::string_view tag = cut(line, ' ');
+      if (tag == "D") {
+        deltas.append(line).push_back('\n');
+        continue;
+      }
+      applyAdded();
+      if (tag == "U") {
+        uint64_t sequence = number<uint64_t>(cut(line, ' '));
+        ItemKind kind = static_cast<ItemKind>(number<uint32_t>(cut(line, ' ')));
+        uint32_t user = handles.at(Name(cut(line, ' ')));
+        std::string_view target = cut(line, ' ');
+        threadRandom().seek(world.randomSeed, sequence);
+        switch (kind) {
+          case ItemKind::Weapon:
+            useItem(world.arsenals[user], world.characters[user], target, line, reply);
+            break;
+          case ItemKind::Potion:
+            useItem(world.medicalBags[user], world.characters[user], target, line, reply);
+            break;
+          case ItemKind::Spell:
+            useItem(world.spellBooks[user], world.characters[user], target, line, reply);
+            break;
+        }
+      } else if (tag == "H" || tag == "K") {
+        std::string_view name = cut(line, ' ');
+        applyChange(character(name), tag, line);
+      } else if (tag == "S") {
+        snapshot = true;
+      } else {
+        throw std::runtime_error("Error caught");
+      }
+    }
+    applyAdded();
+    if (snapshot) {
+      std::ostringstream out;
+      SnapshotWriter(world).write(out);
+      reply = out.str();
+    }
+    sendBatch(fd, reply);
+  }
+}
+
+}  // namespace
+
+// MSG_NOSIGNAL turns a write to a worker that has exited into an error the
+// caller sees, rather than a SIGPIPE that ends the process.
+void sendBatch(int fd, const std::string& batch) {
+  uint32_t length = static_cast<uint32_t>(batch.size());
+  std::string frame(reinterpret_cast<const char*>(&length), sizeof(length));
+  frame += batch;
+  for (size_t sent = 0; sent < frame.size();) {
+    ssize_t written = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+    if (written <= 0)
+      throw std::runtime_error("Error caught");
+    sent += static_cast<size_t>(written);
+  }
+}
+std::optional<std::string> receiveBatch(int fd) {
+  uint32_t length;
+  if (!receiveExactly(fd, reinterpret_cast<char*>(&length), sizeof(length)))
+    return std::nullopt;
+  std::string batch(length, '\0');
+  if (!receiveExactly(fd, batch.data(), length))
+    return std::nullopt;
+  return batch;
+}
+size_t shardOf(uint32_t handle, size_t shardCount) {
+  return static_cast<size_t>((handle * 0x9E3779B97F4A7C15ull) >> 32) % shardCount;
+}
+
+bool ShardCoordinator::supports(const World& world) {
+  auto readsHealth = [](const auto& containers) {
+    for (const auto& container : containers) {
+      for (const auto& [name, item] : container) {
+        if (item.getEffect() != nullptr && item.getEffect()->readsHealth())
+          return true;
+      }
+    }
+    return false;
+  };
+  if (readsHealth(world.arsenals) || readsHealth(world.medicalBags))
+    return false;
+  for (const auto& container : world.spellBooks) {
+    for (const auto& [name, spell] : container) {
+      if (spell.getEffect() != nullptr)
+        return false;
+    }
+  }
+  return true;
+}
+// A worker builds its world from the snapshot it is sent and never reads the
+// copy of the parent it was forked from. It leaves with _exit so it runs none
+// of the parent's exit handlers, and if starting or loading one fails, the
+// ones already running are killed before the throw.
+ShardCoordinator::ShardCoordinator(World& world, size_t shardCount)
+    : world(world), outgoing(shardCount), addedWriter(added) {
+  if (shardCount == 0 || !supports(world))
+    throw std::runtime_error("Error caught");
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle)
+    handles.emplace(world.characters[handle].getName(), handle);
+  for (size_t shard = 0; shard < shardCount; ++shard) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+      stop();
+      throw std::runtime_error("Error caught");
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      close(pair[0]);
+      close(pair[1]);
+      stop();
+      throw std::runtime_error("Error caught");
+    }
+    if (pid == 0) {
+      for (int fd : sockets)
+        close(fd);
+      close(pair[0]);
+      try {
+        ShardWorker(pair[1]).run();
+      } catch (...) {
+        _exit(1);
+      }
+      _exit(0);
+    }
+    close(pair[1]);
+    sockets.push_back(pair[0]);
+    workers.push_back(pid);
+  }
+  try {
+    for (size_t shard = 0; shard < shardCount; ++shard)
+      sendBatch(sockets[shard], shardSnapshot(shard));
+  } catch (...) {
+    stop();
+    throw;
+  }
+}
+ShardCoordinator::~ShardCoordinator() {
+  for (int fd : sockets)
+    close(fd);
+  for (pid_t pid : workers)
+    waitpid(pid, nullptr, 0);
+}
+void ShardCoordinator::stop() {
+  for (int fd : sockets)
+    close(fd);
+  for (pid_t pid : workers) {
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+  sockets.clear();
+  workers.clear();
+}
+std::string ShardCoordinator::shardSnapshot(size_t shard) const {
+  World part;
+  part.randomSeed = world.randomSeed;
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle) {
+    if (shardOf(handle, outgoing.size()) != shard)
+      continue;
+    part.characters.push_back(world.characters[handle]);
+    part.arsenals.push_back(world.arsenals[handle]);
+    part.medicalBags.push_back(world.medicalBags[handle]);
+    part.spellBooks.push_back(world.spellBooks[handle]);
+  }
+  std::ostringstream out;
+  SnapshotWriter(part).write(out);
+  return out.str();
+}
+// Sends every shard its queued lines, even none, and waits for all replies.
+std::vector<std::string> ShardCoordinator::exchange() {
+  for (size_t shard = 0; shard < sockets.size(); ++shard) {
+    sendBatch(sockets[shard], outgoing[shard]);
+    outgoing[shard].clear();
+  }
+  std::vector<std::string> replies;
+  for (int fd : sockets) {
+    std::optional<std::string> reply = receiveBatch(fd);
+    if (!reply)
+      throw std::runtime_error("Error caught");
+    replies.push_back(std::move(*reply));
+  }
+  return replies;
+}
+template <PhysicalDerived T>
+void ShardCoordinator::applyUse(ContainerWithMaxCapacity<T>& container, const SessionEvent& event,
+                                std::string_view reply, std::ostream& out) {
+  std::string_view tag = cut(reply, ' ');
+  if (tag == "E") {
+    out << "Error caught\n";
+    return;
+  }
+  Character& target = world.characters[event.target];
+  writeUse<T>(out, world.characters[event.user], target, event.item);
+  applyChange(target, tag, reply);
+  std::string& forwarded = outgoing[shardOf(event.target, outgoing.size())];
+  forwarded.append(tag).append(" ").append(target.getName().view());
+  if (tag == "H")
+    forwarded.append(" ").append(reply);
+  forwarded.push_back('\n');
+  if constexpr (!std::is_same_v<T, Weapon>)
+    container.remove(Name(event.item));
+  if (target.getHP() <= 0)
+    out << target.getName() << " has died...\n";
+}
+// Each shard answers its uses in the order they were sent, so one cursor per
+// reply walks them back into event order.
+void ShardCoordinator::run(const std::vector<SessionEvent>& events, std::ostream& out, size_t batchSize) {
+  size_t shardCount = sockets.size();
+  for (size_t begin = 0; begin < events.size(); begin += batchSize) {
+    size_t end = std::min(events.size(), begin + batchSize);
+    for (size_t i = begin; i < end; ++i) {
+      const SessionEvent& event = events[i];
+      outgoing[shardOf(event.user, shardCount)]
+          .append("U ")
+          .append(std::to_string(event.sequence))
+          .append(" ")
+          .append(std::to_string(static_cast<uint32_t>(event.kind)))
+          .append(" ")
+          .append(world.characters[event.user].getName().view())
+          .append(" ")
+          .append(world.characters[event.target].getName().view())
+          .append(" ")
+          .append(event.item)
+          .push_back('\n');
+    }
+    std::vector<std::string> replies = exchange();
+    std::vector<std::string_view> cursors(replies.begin(), replies.end());
+    for (size_t i = begin; i < end; ++i) {
+      const SessionEvent& event = events[i];
+      std::string_view reply = cut(cursors[shardOf(event.user, shardCount)], '\n');
+      switch (event.kind) {
+        case ItemKind::Weapon:
+          applyUse(world.arsenals[event.user], event, reply, out);
+          break;
+        case ItemKind::Potion:
+          applyUse(world.medicalBags[event.user], event, reply, out);
+          break;
+        case ItemKind::Spell:
+          applyUse(world.spellBooks[event.user], event, reply, out);
+          break;
+      }
+    }
+  }
+}
+World ShardCoordinator::shard(size_t index) {
+  outgoing[index] += "S\n";
+  sendBatch(sockets[index], outgoing[index]);
+  outgoing[index].clear();
+  std::optional<std::string> snapshot = receiveBatch(sockets[index]);
+  if (!snapshot)
+    throw std::runtime_error("Error caught");
+  return SnapshotView(snapshot->data(), snapshot->size()).restore();
+}
+void ShardCoordinator::queueAdded(uint32_t owner) {
+  std::string& queued = outgoing[shardOf(owner, outgoing.size())];
+  std::string lines = added.str();
+  for (std::string_view rest = lines; !rest.empty();)
+    queued.append("D ").append(cut(rest, '\n')).push_back('\n');
+  added.str({});
+}
+void ShardCoordinator::onCharacterAdded(const World& changed, uint32_t handle) {
+  handles.emplace(changed.characters[handle].getName(), handle);
+  addedWriter.onCharacterAdded(changed, handle);
+  queueAdded(handle);
+}
+void ShardCoordinator::onHealthChanged(const Character&, int) {}
+void ShardCoordinator::onItemAdded(const PhysicalItem& item) {
+  addedWriter.onItemAdded(item);
+  queueAdded(handles.at(item.getOwnerName()));
+}
+void ShardCoordinator::onItemRemoved(const PhysicalItem&) {}
+void ShardCoordinator::onItemConsumed(const PhysicalItem&) {}
+
+// Output of a command waits in buffer until the uses before it have printed.
+void runShardedCommands(std::string_view text, World& world, std::ostream& out, size_t shardCount) {
+  std::optional<ShardCoordinator> coordinator;
+  std::ostringstream buffer;
+  std::vector<SessionEvent> pending;
+  CommandInterpreter interpreter(world, buffer);
+  interpreter.deferUses(&pending);
+  bool started = false;
+  auto flush = [&] {
+    if (pending.empty())
+      return;
+    if (!started) {
+      started = true;
+      if (ShardCoordinator::supports(world)) {
+        coordinator.emplace(world, shardCount);
+        interpreter.setObserver(&*coordinator);
+      }
+    }
+    if (coordinator)
+      coordinator->run(pending, out);
+    else
+      runSession(world, pending, out);
+    pending.clear();
+  };
+  forEachCommandBatch(text, [&](const CommandBatch& batch) {
+    for (const CommandRecord& record : batch.records) {
+      bool isUse = record.keyword == Keyword::Attack || record.keyword == Keyword::Cast ||
+                   record.keyword == Keyword::Drink;
+      if (!isUse)
+        flush();
+      interpreter.execute(batch, record);
+      if (buffer.tellp() > 0) {
+        flush();
+        out << buffer.str();
+        buffer.str({});
+      }
+    }
+    return true;
+  });
+  flush();
+}
@@ -0,0 +1,240 @@
+#include "game/snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SnapshotString SnapshotWriter::intern(std::string_view value) {
+  SnapshotString result{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+  strings += value;
+  return result;
+}
+CharacterRecord SnapshotWriter::record(const Character& character) {
+  return {character.getHP(), intern(character.getName().view())};
+}
+template <PhysicalDerived T>
+void SnapshotWriter::addContainer(uint32_t owner, ItemKind kind, const ContainerWithMaxCapacity<T>& container) {
+  containers.push_back({owner, kind, container.getMaxCapacity(), static_cast<uint32_t>(items.size()),
+                        static_cast<uint32_t>(container.size())});
+  for (const auto& [name, item] : container) {
+    const Formula* effect = item.getEffect();
+    ItemRecord itemRecord{intern(name.view()), 0, static_cast<uint32_t>(targets.size()), 0,
+                          intern(effect != nullptr ? std::string_view(effect->getSource()) : std::string_view()),
+                          item.wasUsed()};
+    if constexpr (std::is_same_v<T, Weapon>) {
+      itemRecord.value = item.getDamage();
+    } else if constexpr (std::is_same_v<T, Potion>) {
+      itemRecord.value = item.getHealValue();
+    } else {
+      for (const Name& target : item.getAllowedTargets())
+        targets.push_back({0, intern(target.view())});
+      itemRecord.targetCount = static_cast<uint32_t>(item.getNumAllowedTargets());
+    }
+    items.push_back(itemRecord);
+  }
+}
+SnapshotWriter::SnapshotWriter(const World& world, SessionPosition position)
+    : randomSeed(world.randomSeed), position(position) {
+  for (const Character& character : world.characters)
+    characters.push_back(record(character));
+  for (uint32_t owner = 0; owner < world.characters.size(); ++owner) {
+    if (owner < world.arsenals.size())
+      addContainer(owner, ItemKind::Weapon, world.arsenals[owner]);
+    if (owner < world.medicalBags.size())
+      addContainer(owner, ItemKind::Potion, world.medicalBags[owner]);
+    if (owner < world.spellBooks.size())
+      addContainer(owner, ItemKind::Spell, world.spellBooks[owner]);
+  }
+}
+void SnapshotWriter::write(std::ostream& out) const {
+  SnapshotHeader header{};
+  std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+  header.version = snapshotVersion;
+  header.characterCount = static_cast<uint32_t>(characters.size());
+  header.containerCount = static_cast<uint32_t>(containers.size());
+  header.itemCount = static_cast<uint32_t>(items.size());
+  header.targetCount = static_cast<uint32_t>(targets.size());
+  header.characterOffset = sizeof(SnapshotHeader);
+  header.containerOffset = header.characterOffset + characters.size() * sizeof(CharacterRecord);
+  header.itemOffset = header.containerOffset + containers.size() * sizeof(ContainerRecord);
+  header.targetOffset = header.itemOffset + items.size() * sizeof(ItemRecord);
+  header.stringOffset = header.targetOffset + targets.size() * sizeof(CharacterRecord);
+  header.stringSize = strings.size();
+  header.randomSeed = randomSeed;
+  header.tick = position.tick;
+  header.nextSequence = position.nextSequence;
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(characters.data()), characters.size() * sizeof(CharacterRecord));
+  out.write(reinterpret_cast<const char*>(containers.data()), containers.size() * sizeof(ContainerRecord));
+  out.write(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(ItemRecord));
+  out.write(reinterpret_cast<const char*>(targets.data()), targets.size() * sizeof(CharacterRecord));
+  out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+}
+
+SnapshotView::SnapshotView(const char* data, size_t length) : data(data), length(length), header(nullptr) {
+  if (length < sizeof(SnapshotHeader))
+    throw std::runtime_error("Error caught");
+  header = reinterpret_cast<const SnapshotHeader*>(data);
+  if (std::memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header->version != snapshotVersion ||
+      !isValid())
+    throw std::runtime_error("Error caught");
+}
+template <typename Record>
+bool SnapshotView::holds(uint64_t offset, uint32_t count) const {
+  return offset % alignof(Record) == 0 && offset <= length && count <= (length - offset) / sizeof(Record);
+}
+bool SnapshotView::holds(SnapshotString value) const {
+  return value.offset <= header->stringSize && value.length <= header->stringSize - value.offset;
+}
+// One pass over every record; restore() relies on all of it.
+bool SnapshotView::isValid() const {
+  if (!holds<CharacterRecord>(header->characterOffset, header->characterCount) ||
+      !holds<ContainerRecord>(header->containerOffset, header->containerCount) ||
+      !holds<ItemRecord>(header->itemOffset, header->itemCount) ||
+      !holds<CharacterRecord>(header->targetOffset, header->targetCount) || header->stringOffset > length ||
+      header->stringSize > length - header->stringOffset)
+    return false;
+  auto validName = [this](SnapshotString name) { return holds(name) && Name::fits(string(name)); };
+  for (const CharacterRecord& record : characters()) {
+    if (!validName(record.name))
+      return false;
+  }
+  for (const CharacterRecord& record : section<CharacterRecord>(header->targetOffset, header->targetCount)) {
+    if (!validName(record.name))
+      return false;
+  }
+  for (const ItemRecord& item : section<ItemRecord>(header->itemOffset, header->itemCount)) {
+    if (!validName(item.name) || !holds(item.effect) || item.firstTarget > header->targetCount ||
+        item.targetCount > header->targetCount - item.firstTarget)
+      return false;
+  }
+  for (const ContainerRecord& container : containers()) {
+    if (container.owner >= header->characterCount || container.kind > ItemKind::Spell || container.maxCapacity < 0 ||
+        container.itemCount > static_cast<uint32_t>(container.maxCapacity) || container.firstItem > header->itemCount ||
+        container.itemCount > header->itemCount - container.firstItem)
+      return false;
+  }
+  return true;
+}
+template <typename Record>
+std::span<const Record> SnapshotView::section(uint64_t offset, uint32_t count) const {
+  return {reinterpret_cast<const Record*>(data + offset), count};
+}
+std::span<const CharacterRecord> SnapshotView::characters() const {
+  return section<CharacterRecord>(header->characterOffset, header->characterCount);
+}
+std::span<const ContainerRecord> SnapshotView::containers() const {
+  return section<ContainerRecord>(header->containerOffset, header->containerCount);
+}
+std::span<const ItemRecord> SnapshotView::items(const ContainerRecord& container) const {
+  return section<ItemRecord>(header->itemOffset, header->itemCount).subspan(container.firstItem, container.itemCount);
+}
+std::span<const CharacterRecord> SnapshotView::targets(const ItemRecord& item) const {
+  return section<CharacterRecord>(header->targetOffset, header->targetCount).subspan(item.firstTarget, item.targetCount);
+}
+std::string_view SnapshotView::string(SnapshotString value) const {
+  return {data + header->stringOffset + value.offset, value.length};
+}
+uint64_t SnapshotView::randomSeed() const {
+  return header->randomSeed;
+}
+SessionPosition SnapshotView::position() const {
+  return {header->tick, header->nextSequence};
+}
+Character SnapshotView::character(const CharacterRecord& record) const {
+  return Character(Name(string(record.name)), record.healthPoints);
+}
+// Items with the same formula source share one compiled formula, and so one
+// prototype. Throws if a stored formula no longer compiles.
+World SnapshotView::restore() const {
+  World world;
+  world.randomSeed = header->randomSeed;
+  for (const CharacterRecord& record : characters())
+    world.characters.push_back(character(record));
+  world.arsenals.assign(world.characters.size(), ContainerWithMaxCapacity<Weapon>(0));
+  world.medicalBags.assign(world.characters.size(), ContainerWithMaxCapacity<Potion>(0));
+  world.spellBooks.assign(world.characters.size(), ContainerWithMaxCapacity<Spell>(0));
+  std::map<std::string_view, std::shared_ptr<const Formula>> formulas;
+  auto restoreState = [&](PhysicalItem& restored, const ItemRecord& item) {
+    restored.setUsed(item.used != 0);
+    if (item.effect.length == 0)
+      return;
+    std::shared_ptr<const Formula>& formula = formulas[string(item.effect)];
+    if (!formula) {
+      std::optional<Formula> compiled = Formula::compile(string(item.effect));
+      if (!compiled)
+        throw std::runtime_error("Error caught");
+      formula = std::make_shared<const Formula>(std::move(*compiled));
+    }
+    restored.setEffect(formula);
+  };
+  for (const ContainerRecord& container : containers()) {
+    const Character& owner = world.characters[container.owner];
+    switch (container.kind) {
+      case ItemKind::Weapon:
+        world.arsenals[container.owner] = ContainerWithMaxCapacity<Weapon>(container.maxCapacity);
+        for (const ItemRecord& item : items(container)) {
+          Weapon weapon(owner, Name(string(item.name)), item.value);
+          restoreState(weapon, item);
+          world.arsenals[container.owner].add(weapon);
+        }
+        break;
+      case ItemKind::Potion:
+        world.medicalBags[container.owner] = ContainerWithMaxCapacity<Potion>(container.maxCapacity);
+        for (const ItemRecord& item : items(container)) {
+          Potion potion(owner, Name(string(item.name)), item.value);
+          restoreState(potion, item);
+          world.medicalBags[container.owner].add(potion);
+        }
+        break;
+      case ItemKind::Spell:
+        world.spellBooks[container.owner] = ContainerWithMaxCapacity<Spell>(container.maxCapacity);
+        for (const ItemRecord& item : items(container)) {
+          std::vector<Character> allowedTargets;
+          for (const CharacterRecord& target : targets(item))
+            allowedTargets.push_back(character(target));
+          Spell spell(owner, Name(string(item.name)), allowedTargets);
+          restoreState(spell, item);
+          world.spellBooks[container.owner].add(spell);
+        }
+        break;
+    }
+  }
+  return world;
+}
+
+MappedSnapshot::MappedSnapshot(const std::string& path) : address(MAP_FAILED), length(0) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Error caught");
+  struct stat info {};
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    length = static_cast<size_t>(info.st_size);
+    address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (address == MAP_FAILED)
+    throw std::runtime_error("Error caught");
+}
+MappedSnapshot::~MappedSnapshot() {
+  munmap(address, length);
+}
+SnapshotView MappedSnapshot::view() const {
+  return SnapshotView(static_cast<const char*>(address), length);
+}
+bool saveSnapshot(const World& world, const std::string& path, SessionPosition position) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out)
+    return false;
+  SnapshotWriter(world, position).write(out);
+  out.close();
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,134 @@
+#include "game/tick_loop.h"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+LatencyRecorder::LatencyRecorder(size_t expectedSamples) {
+  samples.reserve(expectedSamples);
+}
+void LatencyRecorder::record(std::chrono::nanoseconds latency) {
+  samples.push_back(static_cast<uint64_t>(latency.count()));
+}
+size_t LatencyRecorder::size() const {
+  return samples.size();
+}
+std::chrono::nanoseconds LatencyRecorder::percentile(double fraction) const {
+  if (samples.empty())
+    return std::chrono::nanoseconds(0);
+  std::vector<uint64_t> sorted = samples;
+  size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size())));
+  std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+  return std::chrono::nanoseconds(sorted[rank]);
+}
+
+TickLoop::TickLoop(World& world, std::ostream& out, std::chrono::nanoseconds budget)
+    : world(world),
+      out(out),
+      budget(budget),
+      overruns(0),
+      checkpointInterval(0),
+      copiedPages(0),
+      skippedCheckpoints(0),
+      failedCheckpoints(0) {}
+// A checkpoint that comes due while the previous one is still being written
+// is skipped rather than queued.
+void TickLoop::checkpointEvery(size_t interval, std::string path) {
+  checkpointInterval = interval;
+  checkpointPath = std::move(path);
+}
+void TickLoop::recordCheckpoint() {
+  const CheckpointStats& stats = checkpointer.getLast();
+  checkpointPauses.record(stats.pause);
+  checkpointDurations.record(stats.duration);
+  copiedPages += stats.copiedPages;
+  if (!stats.succeeded)
+    ++failedCheckpoints;
+}
+void TickLoop::finishCheckpoints() {
+  if (!checkpointer.running())
+    return;
+  checkpointer.wait();
+  recordCheckpoint();
+}
+// For a loop continuing from a checkpoint: later checkpoints count on from
+// the restored tick and sequence.
+void TickLoop::resumeAt(SessionPosition restored) {
+  position = restored;
+}
+SessionPosition TickLoop::getPosition() const {
+  return position;
+}
+void TickLoop::enqueue(SessionEvent event) {
+  std::lock_guard lock(queueMutex);
+  pending.push_back(std::move(event));
+}
+// The queue is swapped out under the lock, so producers are never blocked for
+// the duration of a tick.
+std::chrono::nanoseconds TickLoop::tick() {
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::lock_guard lock(queueMutex);
+    running.swap(pending);
+  }
+  std::ostringstream tickOutput(std::move(buffer));
+  for (const SessionEvent& event : running) {
+    runEvent(world, event, tickOutput);
+    position.nextSequence = std::max(position.nextSequence, event.sequence + 1);
+  }
+  running.clear();
+  buffer = std::move(tickOutput).str();
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  out.flush();
+  buffer.clear();
+  if (checkpointer.poll())
+    recordCheckpoint();
+  ++position.tick;
+  if (checkpointInterval > 0 && position.tick % checkpointInterval == 0 &&
+      !checkpointer.start(world, checkpointPath, position))
+    ++skippedCheckpoints;
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  latencies.record(elapsed);
+  if (elapsed > budget)
+    ++overruns;
+  return elapsed;
+}
+// Runs ticks on a fixed schedule, calling beforeTick (if given) to feed
+// input first. A late tick starts the next one at once instead of trying to
+// catch up on the ticks it missed.
+void TickLoop::run(size_t ticks, std::chrono::nanoseconds period, const std::function<void(size_t)>& beforeTick) {
+  auto deadline = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ticks; ++i) {
+    if (beforeTick)
+      beforeTick(i);
+    tick();
+    deadline += period;
+    auto now = std::chrono::steady_clock::now();
+    if (deadline > now)
+      std::this_thread::sleep_until(deadline);
+    else
+      deadline = now;
+  }
+}
+const LatencyRecorder& TickLoop::getLatencies() const {
+  return latencies;
+}
+size_t TickLoop::getOverruns() const {
+  return overruns;
+}
+void TickLoop::report(std::ostream& report) const {
+  auto microseconds = [](std::chrono::nanoseconds value) { return static_cast<double>(value.count()) / 1000.0; };
+  report << latencies.size() << " ticks, p50 " << microseconds(latencies.percentile(0.5)) << " us, p99 "
+         << microseconds(latencies.percentile(0.99)) << " us, p99.9 " << microseconds(latencies.percentile(0.999))
+         << " us, max " << microseconds(latencies.percentile(1.0)) << " us, " << overruns << " over the "
+         << microseconds(budget) << " us budget\n";
+  if (checkpointInterval == 0)
+    return;
+  auto milliseconds = [](std::chrono::nanoseconds value) { return static_cast<double>(value.count()) / 1e6; };
+  report << checkpointPauses.size() << " checkpoints (" << failedCheckpoints << " failed, " << skippedCheckpoints
+         << " skipped while busy), fork pause p50 " << microseconds(checkpointPauses.percentile(0.5)) << " us, max "
+         << microseconds(checkpointPauses.percentile(1.0)) << " us, write p50 "
+         << milliseconds(checkpointDurations.percentile(0.5)) << " ms, max "
+         << milliseconds(checkpointDurations.percentile(1.0)) << " ms, " << copiedPages
+         << " pages copied on write\n";
+}
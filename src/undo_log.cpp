@@ -0,0 +1,146 @@
+#include "game/undo_log.h"
+#include "game/random.h"
+
+#include <algorithm>
+#include <optional>
+
+// first..cursor holds undoable entries and cursor..last the redoable ones;
+// positions grow monotonically and are reduced modulo the ring size. A
+// command records at most two entries, so the ring holds at least two.
+UndoLog::UndoLog(World& world, size_t capacity, uint64_t firstSequence)
+    : world(world),
+      ring(std::max<size_t>(capacity, 2)),
+      first(0),
+      cursor(0),
+      last(0),
+      nextCommand(0),
+      nextSequence(firstSequence) {}
+size_t UndoLog::wrap(size_t position) const {
+  return position % ring.size();
+}
+void UndoLog::record(Entry entry) {
+  last = cursor;
+  if (last - first == ring.size()) {
+    uint64_t oldest = ring[wrap(first)].command;
+    while (first < last && ring[wrap(first)].command == oldest)
+      ++first;
+  }
+  ring[wrap(last)] = std::move(entry);
+  cursor = ++last;
+}
+template <PhysicalDerived T>
+ContainerWithMaxCapacity<T>& UndoLog::container(uint32_t owner) {
+  if constexpr (std::is_same_v<T, Weapon>)
+    return world.arsenals[owner];
+  else if constexpr (std::is_same_v<T, Potion>)
+    return world.medicalBags[owner];
+  else
+    return world.spellBooks[owner];
+}
+void UndoLog::changeHealth(Character& character, int delta) {
+  if (delta < 0)
+    character.takeDamage(-delta);
+  else
+    character.heal(delta);
+}
+void UndoLog::apply(const Entry& entry, bool forward) {
+  std::visit(
+      [&](const auto& item) {
+        using T = std::decay_t<decltype(item)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+          changeHealth(world.characters[entry.character], forward ? entry.delta : -entry.delta);
+        } else if (entry.added == forward) {
+          container<T>(entry.character).add(item);
+        } else {
+          container<T>(entry.character).remove(item.getName());
+        }
+      },
+      entry.item);
+}
+ErrorCode UndoLog::takeDamage(uint32_t character, int damage) {
+  if (character >= world.characters.size())
+    return ErrorCode::InvalidHandle;
+  world.characters[character].takeDamage(damage);
+  record({nextCommand++, false, character, -damage, {}});
+  return ErrorCode::Ok;
+}
+ErrorCode UndoLog::heal(uint32_t character, int healVolume) {
+  if (character >= world.characters.size())
+    return ErrorCode::InvalidHandle;
+  world.characters[character].heal(healVolume);
+  record({nextCommand++, false, character, healVolume, {}});
+  return ErrorCode::Ok;
+}
+// Adding over an item of the same name records the displaced item's removal
+// first, so undo puts it back.
+template <PhysicalDerived T>
+ErrorCode UndoLog::add(uint32_t owner, T item) {
+  if (owner >= world.characters.size())
+    return ErrorCode::InvalidHandle;
+  std::optional<T> displaced = container<T>(owner).find(item.getName());
+  if (ErrorCode error = container<T>(owner).add(item); error != ErrorCode::Ok)
+    return error;
+  uint64_t command = nextCommand++;
+  if (displaced)
+    record({command, false, owner, 0, std::move(*displaced)});
+  record({command, true, owner, 0, std::move(item)});
+  return ErrorCode::Ok;
+}
+template <PhysicalDerived T>
+ErrorCode UndoLog::remove(uint32_t owner, const std::string& itemName) {
+  if (owner >= world.characters.size())
+    return ErrorCode::InvalidHandle;
+  std::optional<T> item = Name::fits(itemName) ? container<T>(owner).find(Name(itemName)) : std::nullopt;
+  if (!item)
+    return ErrorCode::ItemNotFound;
+  container<T>(owner).remove(item->getName());
+  record({nextCommand++, false, owner, 0, std::move(*item)});
+  return ErrorCode::Ok;
+}
+template <PhysicalDerived T>
+ErrorCode UndoLog::use(uint32_t user, uint32_t target, const std::string& itemName) {
+  uint64_t sequence = nextSequence++;
+  if (user >= world.characters.size() || target >= world.characters.size())
+    return ErrorCode::InvalidHandle;
+  threadRandom().seek(world.randomSeed, sequence);
+  std::optional<T> item = Name::fits(itemName) ? container<T>(user).find(Name(itemName)) : std::nullopt;
+  if (!item)
+    return ErrorCode::ItemNotFound;
+  Character& targetCharacter = world.characters[target];
+  int before = targetCharacter.getHP();
+  if (ErrorCode error = item->use(world.characters[user], targetCharacter); error != ErrorCode::Ok)
+    return error;
+  uint64_t command = nextCommand++;
+  record({command, false, target, targetCharacter.getHP() - before, {}});
+  if constexpr (!std::is_same_v<T, Weapon>) {
+    std::optional<T> stored = container<T>(user).find(item->getName());
+    container<T>(user).remove(item->getName());
+    record({command, false, user, 0, std::move(*stored)});
+  }
+  return ErrorCode::Ok;
+}
+bool UndoLog::undo() {
+  if (cursor == first)
+    return false;
+  uint64_t command = ring[wrap(cursor - 1)].command;
+  while (cursor > first && ring[wrap(cursor - 1)].command == command)
+    apply(ring[wrap(--cursor)], false);
+  return true;
+}
+bool UndoLog::redo() {
+  if (cursor == last)
+    return false;
+  uint64_t command = ring[wrap(cursor)].command;
+  while (cursor < last && ring[wrap(cursor)].command == command)
+    apply(ring[wrap(cursor++)], true);
+  return true;
+}
+template ErrorCode UndoLog::add<Weapon>(uint32_t, Weapon);
+template ErrorCode UndoLog::remove<Weapon>(uint32_t, const std::string&);
+template ErrorCode UndoLog::use<Weapon>(uint32_t, uint32_t, const std::string&);
+template ErrorCode UndoLog::add<Potion>(uint32_t, Potion);
+template ErrorCode UndoLog::remove<Potion>(uint32_t, const std::string&);
+template ErrorCode UndoLog::use<Potion>(uint32_t, uint32_t, const std::string&);
+template ErrorCode UndoLog::add<Spell>(uint32_t, Spell);
+template ErrorCode UndoLog::remove<Spell>(uint32_t, const std::string&);
+template ErrorCode UndoLog::use<Spell>(uint32_t, uint32_t, const std::string&);
@@ -0,0 +1,35 @@
+#include "game/world.h"
+
+void observeWorld(World& world, WorldObserver* observer) {
+  for (Character& character : world.characters)
+    character.setObserver(observer);
+  for (auto& container : world.arsenals)
+    container.setObserver(observer);
+  for (auto& container : world.medicalBags)
+    container.setObserver(observer);
+  for (auto& container : world.spellBooks)
+    container.setObserver(observer);
+}
+void WorldObservers::add(WorldObserver* observer) {
+  observers.push_back(observer);
+}
+void WorldObservers::onCharacterAdded(const World& world, uint32_t handle) {
+  for (WorldObserver* observer : observers)
+    observer->onCharacterAdded(world, handle);
+}
+void WorldObservers::onHealthChanged(const Character& character, int oldHP) {
+  for (WorldObserver* observer : observers)
+    observer->onHealthChanged(character, oldHP);
+}
+void WorldObservers::onItemAdded(const PhysicalItem& item) {
+  for (WorldObserver* observer : observers)
+    observer->onItemAdded(item);
+}
+void WorldObservers::onItemRemoved(const PhysicalItem& item) {
+  for (WorldObserver* observer : observers)
+    observer->onItemRemoved(item);
+}
+void WorldObservers::onItemConsumed(const PhysicalItem& item) {
+  for (WorldObserver* observer : observers)
+    observer->onItemConsumed(item);
+}
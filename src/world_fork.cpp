@@ -0,0 +1,81 @@
+#include "game/world_fork.h"
+#include "game/random.h"
+
+#include <optional>
+
+WorldFork::WorldFork(const World& world, uint64_t firstSequence)
+    : randomSeed(world.randomSeed),
+      nextSequence(firstSequence),
+      characters(world.characters),
+      arsenals(world.arsenals),
+      medicalBags(world.medicalBags),
+      spellBooks(world.spellBooks) {}
+WorldFork WorldFork::fork() const {
+  return *this;
+}
+size_t WorldFork::size() const {
+  return characters.size();
+}
+const Character& WorldFork::character(uint32_t handle) const {
+  return characters[handle];
+}
+ErrorCode WorldFork::setCharacter(uint32_t handle, const Character& character) {
+  return characters.set(handle, character);
+}
+template <PhysicalDerived T, typename Self>
+auto& WorldFork::containers(Self& self) {
+  if constexpr (std::is_same_v<T, Weapon>)
+    return self.arsenals;
+  else if constexpr (std::is_same_v<T, Potion>)
+    return self.medicalBags;
+  else
+    return self.spellBooks;
+}
+template <PhysicalDerived T>
+const ContainerWithMaxCapacity<T>& WorldFork::container(uint32_t handle) const {
+  return containers<T>(*this)[handle];
+}
+template <PhysicalDerived T>
+ErrorCode WorldFork::setContainer(uint32_t handle, const ContainerWithMaxCapacity<T>& container) {
+  return containers<T>(*this).set(handle, container);
+}
+template <PhysicalDerived T>
+ErrorCode WorldFork::use(uint32_t user, uint32_t target, const std::string& itemName) {
+  uint64_t sequence = nextSequence++;
+  if (user >= size() || target >= size())
+    return ErrorCode::InvalidHandle;
+  threadRandom().seek(randomSeed, sequence);
+  std::optional<T> item = Name::fits(itemName) ? container<T>(user).find(Name(itemName)) : std::nullopt;
+  if (!item)
+    return ErrorCode::ItemNotFound;
+  Character targetCopy = characters[target];
+  if (ErrorCode error = item->use(characters[user], targetCopy); error != ErrorCode::Ok)
+    return error;
+  characters.set(target, targetCopy);
+  if constexpr (!std::is_same_v<T, Weapon>) {
+    ContainerWithMaxCapacity<T> containerCopy = container<T>(user);
+    containerCopy.remove(item->getName());
+    setContainer(user, containerCopy);
+  }
+  return ErrorCode::Ok;
+}
+World WorldFork::materialize() const {
+  World world;
+  world.randomSeed = randomSeed;
+  for (uint32_t handle = 0; handle < size(); ++handle) {
+    world.characters.push_back(characters[handle]);
+    world.arsenals.push_back(arsenals[handle]);
+    world.medicalBags.push_back(medicalBags[handle]);
+    world.spellBooks.push_back(spellBooks[handle]);
+  }
+  return world;
+}
+template const ContainerWithMaxCapacity<Weapon>& WorldFork::container<Weapon>(uint32_t) const;
+template ErrorCode WorldFork::setContainer<Weapon>(uint32_t, const ContainerWithMaxCapacity<Weapon>&);
+template ErrorCode WorldFork::use<Weapon>(uint32_t, uint32_t, const std::string&);
+template const ContainerWithMaxCapacity<Potion>& WorldFork::container<Potion>(uint32_t) const;
+template ErrorCode WorldFork::setContainer<Potion>(uint32_t, const ContainerWithMaxCapacity<Potion>&);
+template ErrorCode WorldFork::use<Potion>(uint32_t, uint32_t, const std::string&);
+template const ContainerWithMaxCapacity<Spell>& WorldFork::container<Spell>(uint32_t) const;
+template ErrorCode WorldFork::setContainer<Spell>(uint32_t, const ContainerWithMaxCapacity<Spell>&);
+template ErrorCode WorldFork::use<Spell>(uint32_t, uint32_t, const std::string&);
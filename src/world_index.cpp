@@ -0,0 +1,102 @@
+#include "game/world_index.h"
+
+#include <charconv>
+#include <limits>
+
+namespace {
+
+bool parseNumber(std::string_view token, int& value) {
+  auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+  return !token.empty() && error == std::errc() && end == token.data() + token.size();
+}
+
+}  // namespace
+
+// Builds the index from the current world; keep it current by passing it to
+// observeWorld, and report characters appended later with onCharacterAdded.
+WorldIndex::WorldIndex(const World& world) : world(world) {
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle)
+    byHealth.emplace(world.characters[handle].getHP(), handle);
+  auto addAll = [this](const auto& containers) {
+    for (const auto& container : containers) {
+      for (const auto& [name, item] : container)
+        onItemAdded(item);
+    }
+  };
+  addAll(world.arsenals);
+  addAll(world.medicalBags);
+  addAll(world.spellBooks);
+}
+void WorldIndex::onCharacterAdded(const World&, uint32_t handle) {
+  byHealth.emplace(world.characters[handle].getHP(), handle);
+}
+// Only characters stored in the world are indexed; anything else is ignored.
+void WorldIndex::onHealthChanged(const Character& character, int oldHP) {
+  const Character* first = world.characters.data();
+  if (&character < first || &character >= first + world.characters.size())
+    return;
+  uint32_t handle = static_cast<uint32_t>(&character - first);
+  byHealth.erase({oldHP, handle});
+  byHealth.emplace(character.getHP(), handle);
+}
+void WorldIndex::onItemAdded(const PhysicalItem& item) {
+  ownersByItem[item.getName()].insert(item.getOwnerName());
+}
+void WorldIndex::onItemRemoved(const PhysicalItem& item) {
+  auto owners = ownersByItem.find(item.getName());
+  if (owners == ownersByItem.end())
+    return;
+  if (auto owner = owners->second.find(item.getOwnerName()); owner != owners->second.end())
+    owners->second.erase(owner);
+  if (owners->second.empty())
+    ownersByItem.erase(owners);
+}
+void WorldIndex::onItemConsumed(const PhysicalItem&) {}
+std::vector<const Character*> WorldIndex::charactersWithHP(int minHP, int maxHP) const {
+  std::vector<const Character*> result;
+  for (auto it = byHealth.lower_bound({minHP, 0}); it != byHealth.end() && it->first <= maxHP; ++it)
+    result.push_back(&world.characters[it->second]);
+  return result;
+}
+std::vector<Name> WorldIndex::ownersOf(const Name& itemName) const {
+  std::vector<Name> result;
+  if (auto owners = ownersByItem.find(itemName); owners != ownersByItem.end()) {
+    for (auto it = owners->second.begin(); it != owners->second.end(); it = owners->second.upper_bound(*it))
+      result.push_back(*it);
+  }
+  return result;
+}
+// Supported queries: "HP below <n>", "HP between <min> <max>" (inclusive) and
+// "Owners <item>". Prints one line of matches, which may be empty; a
+// malformed query prints nothing and returns InvalidValue.
+ErrorCode WorldIndex::query(std::span<const std::string_view> words, std::ostream& out) const {
+  bool first = true;
+  auto print = [&](const auto& value) {
+    out << (first ? "" : " ") << value;
+    first = false;
+  };
+  if (words.size() == 3 && words[0] == "HP" && words[1] == "below") {
+    int limit;
+    if (!parseNumber(words[2], limit))
+      return ErrorCode::InvalidValue;
+    if (limit > std::numeric_limits<int>::min()) {
+      for (const Character* character : charactersWithHP(std::numeric_limits<int>::min(), limit - 1))
+        print(*character);
+    }
+  } else if (words.size() == 4 && words[0] == "HP" && words[1] == "between") {
+    int minHP, maxHP;
+    if (!parseNumber(words[2], minHP) || !parseNumber(words[3], maxHP))
+      return ErrorCode::InvalidValue;
+    for (const Character* character : charactersWithHP(minHP, maxHP))
+      print(*character);
+  } else if (words.size() == 2 && words[0] == "Owners") {
+    if (!Name::fits(words[1]))
+      return ErrorCode::InvalidValue;
+    for (const Name& owner : ownersOf(Name(words[1])))
+      print(owner);
+  } else {
+    return ErrorCode::InvalidValue;
+  }
+  out << '\n';
+  return ErrorCode::Ok;
+}
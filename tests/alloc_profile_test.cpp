@@ -0,0 +1,78 @@
+#include "game/alloc_profile.h"
+#include "test_support.h"
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Row {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  uint64_t largest = 0;
+};
+// The report's rows by tag. Tags may contain spaces; the four numbers end
+// each line.
+std::map<std::string, Row> reportRows() {
+  std::ostringstream report;
+  reportAllocations(report);
+  std::istringstream lines(report.str());
+  std::map<std::string, Row> rows;
+  std::string line;
+  std::getline(lines, line);
+  while (std::getline(lines, line)) {
+    size_t end = line.find_last_not_of(' ', 27);
+    std::istringstream numbers(line.substr(28));
+    Row row;
+    uint64_t average = 0;
+    numbers >> row.allocations >> row.bytes >> average >> row.largest;
+    rows[line.substr(0, end + 1)] = row;
+  }
+  return rows;
+}
+
+void testTaggedAllocationsAreCounted() {
+  Row before = reportRows()["test allocations"];
+  // The blocks are kept until after the report, so the compiler cannot drop
+  // a new/delete pair.
+  std::vector<std::unique_ptr<char[]>> blocks;
+  blocks.reserve(3);
+  {
+    AllocationTag tag("test allocations");
+    blocks.emplace_back(new char[100]);
+    blocks.emplace_back(new char[5000]);
+  }
+  blocks.emplace_back(new char[7000]);
+  Row after = reportRows()["test allocations"];
+  CHECK(after.allocations - before.allocations == 2);
+  CHECK(after.bytes - before.bytes == 5100);
+  CHECK(after.largest == 5000);
+}
+
+// The engine's own tags show up for the operations that carry them.
+void testEngineOperationsAreTagged() {
+  World world;
+  runCommands(world, std::string(sampleCommands) + "Show characters\nDialogue Ann 3 a long line of dialogue\n");
+  std::map<std::string, Row> rows = reportRows();
+  for (const char* tag : {"Container::add", "ItemCatalog::intern", "show formatting"})
+    CHECK(rows[tag].allocations > 0);
+}
+
+}  // namespace
+
+int main() {
+  if (!allocationProfilingEnabled()) {
+    // Without GAME_ALLOC_PROFILE tags cost nothing and there is no report.
+    AllocationTag tag("test allocations");
+    std::ostringstream report;
+    reportAllocations(report);
+    CHECK(report.str().empty());
+    return testResult();
+  }
+  testTaggedAllocationsAreCounted();
+  testEngineOperationsAreTagged();
+  return testResult();
+}
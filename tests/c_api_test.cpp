@@ -0,0 +1,65 @@
+#include "game/c_api.h"
+#include "test_support.h"
+
+#include <cstdint>
+#include <string>
+
+namespace {
+
+void testSessionRoundTrip() {
+  game_session* session = game_session_create(4, 2);
+  CHECK(session != nullptr);
+  uint32_t ann = 0, bob = 0;
+  CHECK(game_create_character(session, "Ann", 50, &ann) == GAME_OK);
+  CHECK(game_create_character(session, "Bob", 40, &bob) == GAME_OK);
+  CHECK(game_create_weapon(session, ann, "Sword", 15) == GAME_OK);
+  CHECK(game_create_potion(session, bob, "Tonic", 5) == GAME_OK);
+  CHECK(game_use(session, GAME_WEAPON, ann, bob, "Sword") == GAME_OK);
+  CHECK(game_use(session, GAME_POTION, bob, bob, "Tonic") == GAME_OK);
+  CHECK(game_use(session, GAME_POTION, bob, bob, "Tonic") == GAME_ITEM_NOT_FOUND);
+  CHECK(game_use(session, GAME_WEAPON, 9, bob, "Sword") == GAME_INVALID_HANDLE);
+  int32_t health = 0;
+  CHECK(game_health(session, bob, &health) == GAME_OK && health == 30);
+  CHECK(game_health(session, 9, &health) == GAME_INVALID_HANDLE);
+  game_inventory_entry entries[2];
+  CHECK(game_inventory(session, ann, GAME_WEAPON, entries, 2) == 1);
+  CHECK(std::string(entries[0].name, entries[0].name_length) == "Sword" && entries[0].value == 15);
+  CHECK(game_create_weapon(session, ann, "ANameThatDoesNotFitInThirtyTwoBytes", 1) == GAME_INVALID_VALUE);
+  CHECK(game_set_effect(session, GAME_WEAPON, ann, "Sword", "base +") == GAME_INVALID_VALUE);
+  game_session_destroy(session);
+}
+
+// Inventories larger than the copy buffer come back whole and in name order.
+void testLargeInventory() {
+  game_session* session = game_session_create(1, 100);
+  uint32_t ann = 0;
+  CHECK(game_create_character(session, "Ann", 50, &ann) == GAME_OK);
+  for (int i = 0; i < 70; ++i) {
+    std::string name = std::string(i < 10 ? "w0" : "w").append(std::to_string(i));
+    CHECK(game_create_weapon(session, ann, name.c_str(), i + 1) == GAME_OK);
+  }
+  game_inventory_entry entries[100];
+  CHECK(game_inventory(session, ann, GAME_WEAPON, entries, 100) == 70);
+  bool ordered = true;
+  for (int i = 0; i < 70; ++i)
+    ordered = ordered && entries[i].value == i + 1;
+  CHECK(ordered && std::string(entries[69].name, entries[69].name_length) == "w69");
+  CHECK(game_inventory(session, ann, GAME_WEAPON, entries, 3) == 70 && entries[2].value == 3);
+  CHECK(game_inventory(session, ann, GAME_WEAPON, nullptr, 0) == 70);
+  game_session_destroy(session);
+}
+
+void testOversizedSessionIsRefused() {
+  // Reserving room for four billion characters cannot succeed; the failure
+  // comes back as NULL instead of an exception escaping into C.
+  CHECK(game_session_create(UINT32_MAX, 2) == nullptr);
+}
+
+}  // namespace
+
+int main() {
+  testSessionRoundTrip();
+  testLargeInventory();
+  testOversizedSessionIsRefused();
+  return testResult();
+}
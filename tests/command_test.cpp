@@ -0,0 +1,87 @@
+#include "game/command.h"
+#include "test_support.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Every word the hash must accept or reject agrees with the comparison
+// chain it replaced: the keywords, their neighbours and random words.
+void testHashAgreesWithComparisons() {
+  std::vector<std::string> words;
+  for (std::string_view name : keywordNames) {
+    std::string word(name);
+    words.push_back(word);
+    words.push_back(word.substr(0, word.size() - 1));
+    words.push_back(word + "s");
+    words.push_back(" " + word);
+    std::string flipped = word;
+    flipped[0] = static_cast<char>(flipped[0] ^ 0x20);
+    words.push_back(flipped);
+    std::string middle = word;
+    middle[word.size() / 2] = '#';
+    words.push_back(middle);
+  }
+  std::mt19937 random(11);
+  for (int i = 0; i < 20000; ++i) {
+    std::string word(1 + random() % 10, ' ');
+    for (char& letter : word)
+      letter = static_cast<char>(random() % 2 == 0 ? 'a' + random() % 26 : 'A' + random() % 26);
+    words.push_back(word);
+  }
+  words.push_back("");
+  bool agrees = true;
+  for (const std::string& word : words)
+    agrees = agrees && keywordOf(word) == keywordByComparison(word);
+  CHECK(agrees);
+  for (size_t index = 0; index < keywordCount; ++index)
+    CHECK(keywordOf(keywordNames[index]) == static_cast<Keyword>(index));
+}
+
+void testCommandsDispatchByFirstWord() {
+  World world;
+  std::string output = runCommands(world, std::string(sampleCommands) +
+                                              "Attack Ann Bob Axe\n"
+                                              "Drink Bob Bob Elixir\n"
+                                              "Cast Cid Ann Doom\n"
+                                              "Dialogue Bob 2 hello there\n"
+                                              "Show weapons Ann\n");
+  CHECK(output.find("Ann attacks Bob with their Axe!") != std::string::npos);
+  CHECK(output.find("Bob drinks Elixir from Bob.") != std::string::npos);
+  CHECK(output.find("Cid casts Doom on Ann!") != std::string::npos);
+  CHECK(output.find("Bob: hello there") != std::string::npos);
+  CHECK(output.ends_with("Axe:25 Sword:15\n"));
+}
+
+void testUnknownWordsAreErrors() {
+  World world;
+  runCommands(world, sampleCommands);
+  std::string before = runCommands(world, "Show characters\n");
+  std::string output = runCommands(world, "attack Ann Bob Axe\nAttacks Ann Bob Axe\nCreate items weapon Ann Mace 3\n"
+                                          "Create item sword Ann Mace 3\nShow Weapons Ann\nJump\n");
+  CHECK(output == "Error caught\nError caught\nError caught\nError caught\nError caught\nError caught\n");
+  CHECK(runCommands(world, "Show characters\n") == before);
+  CHECK(runCommands(world, "   \n\t\n").empty());
+}
+
+// Weapons and potions must be worth something, as GameSession requires.
+void testWorthlessItemsAreRefused() {
+  World world;
+  runCommands(world, sampleCommands);
+  std::string output = runCommands(world, "Create item weapon Ann Club 0\nCreate item potion Bob Water -5\n"
+                                          "Create item weapon Ann Club 1\n");
+  CHECK(output == "Error caught\nError caught\nAnn just obtained a new weapon called Club.\n");
+  CHECK(runCommands(world, "Show weapons Ann\nShow potions Bob\n") == "Axe:25 Club:1 Sword:15\nElixir:35\n");
+}
+
+}  // namespace
+
+int main() {
+  testHashAgreesWithComparisons();
+  testCommandsDispatchByFirstWord();
+  testUnknownWordsAreErrors();
+  testWorthlessItemsAreRefused();
+  return testResult();
+}
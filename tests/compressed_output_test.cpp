@@ -0,0 +1,93 @@
+#include "game/compressed_output.h"
+#include "game/lz4.h"
+#include "test_support.h"
+
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string decode(std::string_view archive) {
+  std::string text;
+  for (const lz4::Block& block : lz4::frameBlocks(archive)) {
+    if (!block.compressed) {
+      text.append(block.data, block.size);
+      continue;
+    }
+    std::string decoded(lz4::maxBlockSize, '\0');
+    std::optional<size_t> size = lz4::decompressBlock(block.data, block.size, decoded.data(), decoded.size());
+    CHECK(size.has_value());
+    text.append(decoded, 0, size.value_or(0));
+  }
+  return text;
+}
+// Offsets where each frame of archive starts.
+std::vector<size_t> frameStarts(const std::string& archive) {
+  std::vector<size_t> starts;
+  for (size_t position = 0; position < archive.size();) {
+    starts.push_back(position);
+    position += lz4::frameHeaderSize;
+    for (;;) {
+      uint32_t header = 0;
+      std::memcpy(&header, archive.data() + position, sizeof(header));
+      position += sizeof(header);
+      if (header == 0)
+        break;
+      position += header & 0x7FFFFFFFu;
+    }
+  }
+  return starts;
+}
+
+void testOutputDecodesToWhatWasWritten() {
+  std::ostringstream target;
+  std::string text;
+  for (int line = 0; line < 3000; ++line)
+    text += "Ann attacks Bob with their Sword! (" + std::to_string(line % 7) + ")\n";
+  {
+    CompressingStreamBuffer buffer(target, 4096, 2);
+    std::ostream out(&buffer);
+    out << text;
+    buffer.finish();
+    CHECK(buffer.uncompressedBytes() == text.size());
+    CHECK(buffer.compressedBytes() == target.str().size());
+    CHECK(buffer.compressedBytes() < text.size() / 4);
+  }
+  CHECK(decode(target.str()) == text);
+  CHECK(frameStarts(target.str()).size() == (text.size() + 4095) / 4096);
+}
+
+// Every flush closes a frame, and each frame decodes on its own, so a
+// stream cut at a frame boundary keeps everything before the cut.
+void testFlushesEndFrames() {
+  std::ostringstream target;
+  CompressingStreamBuffer buffer(target);
+  std::ostream out(&buffer);
+  out << "tick one\n" << std::flush;
+  out << std::flush;
+  out << "tick two\n" << std::flush;
+  out << "tick three\n";
+  buffer.finish();
+  std::string archive = target.str();
+  std::vector<size_t> starts = frameStarts(archive);
+  CHECK(starts.size() == 3);
+  CHECK(decode(archive) == "tick one\ntick two\ntick three\n");
+  CHECK(decode(std::string_view(archive).substr(0, starts[2])) == "tick one\ntick two\n");
+  CHECK(decode(std::string_view(archive).substr(starts[1], starts[2] - starts[1])) == "tick two\n");
+
+  out << "late";
+  out.flush();
+  CHECK(!out);
+  CHECK(target.str() == archive);
+}
+
+}  // namespace
+
+int main() {
+  testOutputDecodesToWhatWasWritten();
+  testFlushesEndFrames();
+  return testResult();
+}
@@ -0,0 +1,77 @@
+#include "game/cycle_profiler.h"
+#include "test_support.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Sample counts per slot, read back from the report table.
+std::map<std::string, uint64_t> samplesOf(const CycleProfiler& profiler) {
+  std::ostringstream report;
+  profiler.report(report);
+  std::istringstream lines(report.str());
+  std::map<std::string, uint64_t> samples;
+  std::string line;
+  std::getline(lines, line);
+  std::getline(lines, line);
+  for (std::string slot; lines >> slot;) {
+    if (slot == "(invalid)" || slot.find("::") != std::string::npos || keywordOf(slot) != Keyword::Unknown)
+      lines >> samples[slot];
+    std::getline(lines, line);
+  }
+  return samples;
+}
+
+void testSamplesAreAttributedToCommands() {
+  World world;
+  CycleProfiler profiler;
+  CHECK(CycleProfiler::active() == &profiler);
+  runCommands(world, std::string(sampleCommands) +
+                         "Attack Ann Bob Axe\nAttack Ann Bob Club\nDrink Bob Bob Elixir\nCast Cid Ann Doom\n"
+                         "Show characters\nJump\n");
+  std::map<std::string, uint64_t> samples = samplesOf(profiler);
+  std::map<std::string, uint64_t> expected = {
+      {"Create", 12}, {"Attack", 2}, {"Drink", 1}, {"Cast", 1}, {"Show", 1}, {"(invalid)", 1},
+      {"Weapon::useLogic", 1}, {"Potion::useLogic", 1}, {"Spell::useLogic", 1},
+  };
+  CHECK(samples == expected);
+}
+
+// The innermost profiler collects; the outer one resumes when it goes.
+void testProfilersNest() {
+  CHECK(CycleProfiler::active() == nullptr);
+  World world;
+  CycleProfiler outer;
+  runCommands(world, "Create character fighter Ann 120\n");
+  {
+    CycleProfiler inner;
+    CHECK(CycleProfiler::active() == &inner);
+    runCommands(world, "Show characters\n");
+    CHECK(samplesOf(inner) == (std::map<std::string, uint64_t>{{"Show", 1}}));
+  }
+  CHECK(CycleProfiler::active() == &outer);
+  runCommands(world, "Dialogue Ann 1 hi\n");
+  CHECK(samplesOf(outer) == (std::map<std::string, uint64_t>{{"Create", 1}, {"Dialogue", 1}}));
+}
+
+void testCountersAdvance() {
+  HardwareCounters counters;
+  CounterSample start = counters.read();
+  World world;
+  runCommands(world, sampleCommands);
+  CounterSample end = counters.read();
+  CHECK(end.cycles > start.cycles);
+  if (counters.has(1))
+    CHECK(end.instructions > start.instructions);
+}
+
+}  // namespace
+
+int main() {
+  testSamplesAreAttributedToCommands();
+  testProfilersNest();
+  testCountersAdvance();
+  return testResult();
+}
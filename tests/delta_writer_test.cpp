@@ -0,0 +1,94 @@
+#include "game/delta_writer.h"
+#include "test_support.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+constexpr std::string_view session =
+    "Attack Ann Bob Sword\n"
+    "Drink Ann Ann Tonic\n"
+    "Cast Cid Bob Doom\n"
+    "Create character fighter Dan 60\n"
+    "Create item weapon Dan Club 7\n"
+    "Create item weapon Ann Sword 18\n"
+    "Attack Dan Cid Club\n"
+    "Cast Bob Cid Spark\n";
+
+std::string inventoryOf(World& world) {
+  std::string commands = "Show characters\n";
+  for (const Character& character : world.characters) {
+    std::string name(character.getName().view());
+    commands += "Show weapons " + name + "\nShow potions " + name + "\nShow spells " + name + "\n";
+  }
+  return runCommands(world, commands);
+}
+
+void testDeltasRebuildTheWorld() {
+  World original;
+  std::ostringstream deltas;
+  DeltaWriter writer(deltas);
+  {
+    std::ostringstream out;
+    CommandInterpreter interpreter(original, out);
+    interpreter.setObserver(&writer);
+    interpreter.execute(sampleCommands);
+    interpreter.execute(session);
+  }
+  World rebuilt;
+  std::istringstream in(deltas.str());
+  CHECK(applyDeltas(in, rebuilt) == ErrorCode::Ok);
+  CHECK(rebuilt.characters.size() == 4);
+  CHECK(inventoryOf(rebuilt) == inventoryOf(original));
+  CHECK(rebuilt.arsenals[3].getMaxCapacity() == 3 && rebuilt.spellBooks[1].getMaxCapacity() == 2);
+}
+
+void testDeltaLines() {
+  World world;
+  std::ostringstream deltas;
+  DeltaWriter writer(deltas);
+  {
+    std::ostringstream out;
+    CommandInterpreter interpreter(world, out);
+    interpreter.setObserver(&writer);
+    interpreter.execute("Create character archer Bob 90\nCreate item spell Bob Spark 1 Bob\n"
+                        "Create item potion Bob Elixir 5\nDrink Bob Bob Elixir\n");
+  }
+  CHECK(deltas.str() ==
+        "C Bob 90 2 3 2\n"
+        "+ spell Bob Spark 1 Bob\n"
+        "+ potion Bob Elixir 5\n"
+        "H Bob 95\n"
+        "U potion Bob Elixir\n"
+        "- potion Bob Elixir\n");
+  // Once the interpreter is gone, its observer no longer hears about changes.
+  runCommands(world, "Create item weapon Bob Bow 3\n");
+  CHECK(deltas.str().find("Bow") == std::string::npos);
+}
+
+void testBadDeltasAreRejected() {
+  auto apply = [](std::string_view text) {
+    World world;
+    std::istringstream in{std::string(text)};
+    return applyDeltas(in, world);
+  };
+  CHECK(apply("C Ann 10 1 1 1\nH Ann 4\n\n") == ErrorCode::Ok);
+  CHECK(apply("H Ann 4\n") == ErrorCode::InvalidValue);
+  CHECK(apply("C Ann 10 1 1\n") == ErrorCode::InvalidValue);
+  CHECK(apply("C Ann 10 1 1 1\nC Ann 10 1 1 1\n") == ErrorCode::InvalidValue);
+  CHECK(apply("C Ann 10 1 1 1\n+ shield Ann Wall 3\n") == ErrorCode::InvalidValue);
+  CHECK(apply("C Ann 10 1 1 1\n- weapon Ann Sword\n") == ErrorCode::ItemNotFound);
+  CHECK(apply("C Ann 10 1 1 1\n+ weapon Ann A 1\n+ weapon Ann B 1\n") == ErrorCode::ContainerFull);
+  CHECK(apply("C Ann 10 1 1 1\n+ spell Ann Zap 2 Ann\n") == ErrorCode::InvalidValue);
+  CHECK(apply("X\n") == ErrorCode::InvalidValue);
+}
+
+}  // namespace
+
+int main() {
+  testDeltasRebuildTheWorld();
+  testDeltaLines();
+  testBadDeltasAreRejected();
+  return testResult();
+}
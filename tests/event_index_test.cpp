@@ -0,0 +1,111 @@
+#include "game/event_index.h"
+#include "test_support.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string sampleLog() {
+  std::string log(sampleCommands);
+  log += "\nAttack Ann Bob Sword\n  \nDrink Ann Ann Tonic\nDialogue Bob 1 ouch\nAttack Bob Ann Bow\n"
+         "Cast Cid Ann Doom\nAttack Ann Cid Axe\nShow characters\n";
+  return log;
+}
+std::string bytesOf(const EventIndex& index) {
+  std::ostringstream out;
+  index.write(out);
+  return out.str();
+}
+bool rejects(const std::string& bytes) {
+  std::istringstream in(bytes);
+  try {
+    EventIndex::read(in);
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+bool rejectsEdit(const std::string& valid, const std::function<void(EventIndexHeader&, EventCheckpoint*)>& change) {
+  std::string bytes = valid;
+  EventIndexHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  change(header, reinterpret_cast<EventCheckpoint*>(bytes.data() + sizeof(header)));
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  return rejects(bytes);
+}
+// What Show characters prints after the first count events of log.
+std::string stateAfter(const std::string& log, uint64_t count) {
+  std::string prefix;
+  std::istringstream in(log);
+  for (std::string line; count > 0 && std::getline(in, line);) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+    prefix += line + '\n';
+    --count;
+  }
+  World world;
+  runCommands(world, prefix);
+  return runCommands(world, "Show characters\n");
+}
+
+void testIndexFindsEvents() {
+  std::string log = sampleLog();
+  std::istringstream in(bytesOf(EventIndex::build(log, 4)));
+  EventIndex index = EventIndex::read(in);
+  CHECK(index.getEventCount() == 19 && index.getInterval() == 4 && index.getLogSize() == log.size());
+  std::optional<uint64_t> offset = index.offsetOf(log, 13);
+  CHECK(offset && log.compare(*offset, 19, "Drink Ann Ann Tonic") == 0);
+  CHECK(!index.offsetOf(log, 19));
+  CHECK(!index.offsetOf(log + "\n", 13));
+}
+
+void testStateAtMatchesReplay() {
+  std::string log = sampleLog();
+  std::string path = temporaryPath("events.idx");
+  EventIndex index = EventIndex::build(log, 5, path);
+  for (uint64_t event : {0, 4, 5, 13, 16, 18}) {
+    std::ostringstream out;
+    CHECK(printStateAt(log, index, path, event, out));
+    CHECK(out.str() == stateAfter(log, event));
+  }
+  std::ostringstream out;
+  CHECK(!printStateAt(log + "Show characters\n", index, path, 13, out));
+  std::remove(checkpointSnapshotPath(path, 2).c_str());
+  CHECK(!printStateAt(log, index, path, 13, out));
+  for (size_t number = 0; number < 4; ++number)
+    std::remove(checkpointSnapshotPath(path, number).c_str());
+  CHECK_THROWS(EventIndex::build(log, 5, temporaryPath("missing/events.idx")));
+}
+
+void testCorruptIndexesAreRejected() {
+  std::string valid = bytesOf(EventIndex::build(sampleLog(), 4));
+  CHECK(!rejects(valid));
+  CHECK(rejects(valid.substr(0, 10)));
+  CHECK(rejects(valid.substr(0, valid.size() - 1)));
+  CHECK(rejects(valid + "x"));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader& header, EventCheckpoint*) { header.interval = 0; }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader& header, EventCheckpoint*) { header.checkpointCount = ~0ull / 2; }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader& header, EventCheckpoint*) { header.eventCount = 100; }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader& header, EventCheckpoint*) { header.magic[0] = 'X'; }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader& header, EventCheckpoint* checkpoints) {
+    checkpoints[4].offset = header.logSize;
+  }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader&, EventCheckpoint* checkpoints) { checkpoints[2].event = 9; }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader&, EventCheckpoint* checkpoints) {
+    std::swap(checkpoints[1].offset, checkpoints[2].offset);
+  }));
+  CHECK(rejectsEdit(valid, [](EventIndexHeader&, EventCheckpoint* checkpoints) { checkpoints[1].sequence = 5; }));
+}
+
+}  // namespace
+
+int main() {
+  testIndexFindsEvents();
+  testStateAtMatchesReplay();
+  testCorruptIndexesAreRejected();
+  return testResult();
+}
@@ -0,0 +1,75 @@
+#include "game/item.h"
+#include "game/item_catalog.h"
+#include "test_support.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void testEqualDefinitionsShareOnePrototype() {
+  ItemCatalog catalog;
+  auto formula = std::make_shared<const Formula>(*Formula::compile("base * 2"));
+  const ItemPrototype* sword = catalog.intern({Name("Sword"), 15, {}, nullptr});
+  CHECK(catalog.intern({Name("Sword"), 15, {}, nullptr}) == sword);
+  CHECK(catalog.intern({Name("Sword"), 16, {}, nullptr}) != sword);
+  CHECK(catalog.intern({Name("Sword"), 15, {}, formula}) != sword);
+  CHECK(catalog.intern({Name("Sword"), 15, {}, formula}) == catalog.intern({Name("Sword"), 15, {}, formula}));
+  const ItemPrototype* spell = catalog.intern({Name("Doom"), 0, {Name("Ann"), Name("Bob")}, nullptr});
+  CHECK(catalog.intern({Name("Doom"), 0, {Name("Bob"), Name("Ann")}, nullptr}) != spell);
+  CHECK(catalog.intern({Name("Doom"), 0, {Name("Ann"), Name("Bob")}, nullptr}) == spell);
+  CHECK(catalog.size() == 5);
+  CHECK(catalog.internName(Name("Ann")) == catalog.internName(Name("Ann")));
+  CHECK(catalog.internName(Name("Ann")) != catalog.internName(Name("Bob")));
+  CHECK(catalog.size() == 5);
+}
+
+// Instances share a prototype but keep their own owner and state; a new
+// effect moves one instance to another prototype and leaves the rest alone.
+void testInstancesKeepTheirOwnState() {
+  Character ann(Name("Ann"), 100);
+  Character bob(Name("Bob"), 100);
+  const ItemPrototype* tonic = ItemCatalog::shared().intern({Name("Tonic"), 20, {}, nullptr});
+  Potion mine(ann, tonic);
+  Potion yours(bob, Name("Tonic"), 20);
+  mine.setUsed(true);
+  CHECK(mine.wasUsed() && !yours.wasUsed());
+  CHECK(mine.getOwnerName() == Name("Ann") && yours.getOwnerName() == Name("Bob"));
+  CHECK(mine.getHealValue() == 20 && yours.getHealValue() == 20);
+
+  Weapon axe(ann, Name("Axe"), 25);
+  Weapon copy = axe;
+  copy.setEffect(std::make_shared<const Formula>(*Formula::compile("base + 5")));
+  CHECK(axe.getEffect() == nullptr && copy.getEffect() != nullptr);
+  CHECK(Weapon(ann, Name("Axe"), 25).getEffect() == nullptr);
+  Character target(Name("Cid"), 100);
+  CHECK(copy.use(ann, target) == ErrorCode::Ok && target.getHP() == 70);
+  CHECK(axe.use(ann, target) == ErrorCode::Ok && target.getHP() == 45);
+}
+
+void testConcurrentInterningAgrees() {
+  ItemCatalog catalog;
+  std::vector<std::vector<const ItemPrototype*>> seen(4);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < seen.size(); ++t) {
+    threads.emplace_back([&catalog, &found = seen[t]] {
+      for (int value = 0; value < 500; ++value)
+        found.push_back(catalog.intern({Name("Bow"), value, {}, nullptr}));
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  CHECK(catalog.size() == 500);
+  for (size_t t = 1; t < seen.size(); ++t)
+    CHECK(seen[t] == seen[0]);
+}
+
+}  // namespace
+
+int main() {
+  testEqualDefinitionsShareOnePrototype();
+  testInstancesKeepTheirOwnState();
+  testConcurrentInterningAgrees();
+  return testResult();
+}
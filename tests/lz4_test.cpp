@@ -0,0 +1,121 @@
+#include "game/command_file.h"
+#include "game/lz4.h"
+#include "test_support.h"
+
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::optional<std::string> roundTrip(const std::string& text) {
+  std::string compressed(lz4::compressBound(text.size()), '\0');
+  compressed.resize(lz4::compressBlock(text.data(), text.size(), compressed.data()));
+  std::string restored(text.size(), '\0');
+  std::optional<size_t> size = lz4::decompressBlock(compressed.data(), compressed.size(), restored.data(),
+                                                    restored.size());
+  if (!size)
+    return std::nullopt;
+  restored.resize(*size);
+  return restored;
+}
+// A command log long enough to span many small blocks.
+std::string sampleLog() {
+  std::string log(sampleCommands);
+  for (int round = 0; round < 200; ++round)
+    log += "Attack Ann Bob Sword\nDialogue Cid 2 round " + std::to_string(round) + "\nShow characters\n";
+  return log;
+}
+// One frame holding text in blocks of blockSize bytes, so lines are cut at
+// block edges.
+std::string archiveOf(std::string_view text, size_t blockSize) {
+  std::ostringstream out;
+  std::string scratch;
+  lz4::writeFrameHeader(out);
+  for (size_t offset = 0; offset < text.size(); offset += blockSize)
+    lz4::writeBlock(out, text.data() + offset, std::min(blockSize, text.size() - offset), scratch);
+  lz4::writeFrameEnd(out);
+  return out.str();
+}
+std::string runArchive(const std::string& archive, size_t threads) {
+  World world;
+  std::ostringstream out;
+  CommandInterpreter interpreter(world, out);
+  runCommandInput(archive, interpreter, threads);
+  return out.str();
+}
+
+void testChecksumMatchesReference() {
+  CHECK(lz4::xxh32("", 0) == 0x02CC5D05u);
+  CHECK(lz4::xxh32("abc", 3) == 0x32D153FFu);
+}
+
+void testBlocksRoundTrip() {
+  std::mt19937 random(7);
+  std::string noise(70000, '\0');
+  for (char& byte : noise)
+    byte = static_cast<char>(random());
+  std::string repeated;
+  for (int i = 0; i < 5000; ++i)
+    repeated += "Attack Ann Bob Sword\n";
+  for (const std::string& text : {std::string(), std::string("x"), std::string(100, 'a'), noise, repeated,
+                                  sampleLog()})
+    CHECK(roundTrip(text) == text);
+
+  std::string compressed(lz4::compressBound(repeated.size()), '\0');
+  compressed.resize(lz4::compressBlock(repeated.data(), repeated.size(), compressed.data()));
+  CHECK(compressed.size() < repeated.size() / 20);
+  std::string small(repeated.size() - 1, '\0');
+  CHECK(!lz4::decompressBlock(compressed.data(), compressed.size(), small.data(), small.size()));
+  CHECK(!lz4::decompressBlock(compressed.data(), compressed.size() / 2, small.data(), small.size()));
+  const char badOffset[] = {0x10, 'A', 0x05, 0x00, 0x00};
+  CHECK(!lz4::decompressBlock(badOffset, sizeof(badOffset), small.data(), small.size()));
+}
+
+// Small blocks put line cuts at block and window edges; every thread count
+// prints what the plain text does.
+void testCompressedRunMatchesText() {
+  std::string log = sampleLog();
+  std::string expected = runArchive(log, 1);
+  for (size_t blockSize : {size_t{37}, size_t{100}, size_t{4096}}) {
+    std::string archive = archiveOf(log, blockSize);
+    CHECK(lz4::isFrame(archive) && !lz4::isFrame(log));
+    CHECK(lz4::frameBlocks(archive).size() == (log.size() + blockSize - 1) / blockSize);
+    for (size_t threads : {1, 3})
+      CHECK(runArchive(archive, threads) == expected);
+  }
+  // Concatenated frames read as one stream.
+  CHECK(runArchive(archiveOf(log, 50) + archiveOf("Show characters\n", 50), 2) ==
+        runArchive(log + "Show characters\n", 1));
+}
+
+void testCorruptArchivesThrow() {
+  std::string archive = archiveOf(sampleLog(), 1000);
+  std::string badChecksum = archive;
+  badChecksum[6] = static_cast<char>(badChecksum[6] ^ 1);
+  CHECK_THROWS(lz4::frameBlocks(badChecksum));
+  CHECK_THROWS(lz4::frameBlocks(archive.substr(0, archive.size() - 2)));
+  CHECK_THROWS(lz4::frameBlocks(archive.substr(0, archive.size() / 2)));
+  std::string oversized = archive;
+  oversized[lz4::frameHeaderSize + 3] = 0x7F;
+  CHECK_THROWS(lz4::frameBlocks(oversized));
+
+  std::ostringstream broken;
+  lz4::writeFrameHeader(broken);
+  broken.write("\x05\x00\x00\x00", 4);
+  broken.write("\x10" "A\x05\x00\x00", 5);
+  lz4::writeFrameEnd(broken);
+  CHECK_THROWS(runArchive(broken.str(), 1));
+}
+
+}  // namespace
+
+int main() {
+  testChecksumMatchesReference();
+  testBlocksRoundTrip();
+  testCompressedRunMatchesText();
+  testCorruptArchivesThrow();
+  return testResult();
+}
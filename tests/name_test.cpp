@@ -0,0 +1,54 @@
+#include "game/game_session.h"
+#include "game/name.h"
+#include "test_support.h"
+
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+
+static_assert(!std::is_convertible_v<std::string, Name> && !std::is_convertible_v<const char*, Name> &&
+              !std::is_convertible_v<std::string_view, Name>);
+
+void testNamesCompareLikeStrings() {
+  CHECK(Name("Ann") == Name(std::string("Ann")));
+  CHECK(Name("Ann") != Name("Anne"));
+  CHECK(Name("Ann") < Name("Anne") && Name("Anne") < Name("Bob"));
+  CHECK(Name("Bob").view() == "Bob" && Name("Bob").size() == 3 && Name().empty());
+  std::string longest(Name::capacity, 'x');
+  CHECK(Name::fits(longest) && !Name::fits(longest + "x"));
+  CHECK(Name(longest).view() == longest);
+  std::unordered_map<Name, int> map{{Name("Ann"), 1}, {Name("Bob"), 2}};
+  CHECK(map.at(Name("Bob")) == 2 && !map.contains(Name("Cid")));
+}
+
+// A use naming an item one byte too long must not match the item whose name
+// is its first 31 bytes.
+void testOverlongItemNamesDoNotMatch() {
+  std::string stored(Name::capacity, 'k');
+  std::string overlong = stored + "!";
+  World world;
+  std::string output = runCommands(world, "Create character fighter Ann 50\nCreate character fighter Bob 50\n"
+                                          "Create item weapon Ann " + stored + " 10\n"
+                                          "Attack Ann Bob " + overlong + "\n"
+                                          "Create item weapon Ann " + overlong + " 10\n"
+                                          "Show characters\n");
+  CHECK(output.ends_with("Error caught\nError caught\nAnn:50 Bob:50\n"));
+
+  GameSession session(2, 2);
+  uint32_t ann = 0, bob = 0;
+  session.createCharacter("Ann", 50, ann);
+  session.createCharacter("Bob", 50, bob);
+  CHECK(session.createWeapon(ann, stored, 10) == ErrorCode::Ok);
+  CHECK(session.use(ItemKind::Weapon, ann, bob, overlong) == ErrorCode::ItemNotFound);
+  CHECK(session.use(ItemKind::Weapon, ann, bob, stored) == ErrorCode::Ok);
+}
+
+}  // namespace
+
+int main() {
+  testNamesCompareLikeStrings();
+  testOverlongItemNamesDoNotMatch();
+  return testResult();
+}
@@ -0,0 +1,160 @@
+#include "game/persistent.h"
+#include "game/world_fork.h"
+#include "test_support.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void testVectorVersionsAreIndependent() {
+  std::vector<int> values;
+  for (int i = 0; i < 1000; ++i)
+    values.push_back(i);
+  PersistentVector<int> original(values);
+  PersistentVector<int> changed = original;
+  CHECK(changed.set(999, -1) == ErrorCode::Ok);
+  CHECK(changed.set(40, -2) == ErrorCode::Ok);
+  CHECK(original[999] == 999 && original[40] == 40);
+  CHECK(changed[999] == -1 && changed[40] == -2 && changed[41] == 41);
+  CHECK(changed.set(1000, 5) == ErrorCode::InvalidHandle);
+  CHECK(changed.size() == 1000);
+}
+
+// The constructor builds the trie level by level; sizes at and just past a
+// full level must keep every value at its index.
+void testVectorBuildsEveryDepth() {
+  for (size_t size : {0, 1, 32, 33, 1024, 1025, 40000}) {
+    std::vector<size_t> values;
+    for (size_t i = 0; i < size; ++i)
+      values.push_back(i * 7);
+    PersistentVector<size_t> vector(values);
+    CHECK(vector.size() == size);
+    bool same = true;
+    for (size_t i = 0; i < size; ++i)
+      same = same && vector[i] == i * 7;
+    CHECK(same);
+    if (size > 0) {
+      CHECK(vector.set(size - 1, 1) == ErrorCode::Ok);
+      CHECK(vector[size - 1] == 1);
+    }
+  }
+}
+
+// Copies of a container are versions: changing one leaves the others as
+// they were.
+void testContainerVersionsAreIndependent() {
+  World world;
+  runCommands(world, sampleCommands);
+  ContainerWithMaxCapacity<Weapon> first = world.arsenals[0];
+  ContainerWithMaxCapacity<Weapon> second = first;
+  CHECK(second.add(Weapon(world.characters[0], Name("Club"), 3)) == ErrorCode::Ok);
+  ContainerWithMaxCapacity<Weapon> third = second;
+  CHECK(third.remove(Name("Sword")) == ErrorCode::Ok);
+  CHECK(first.size() == 2 && second.size() == 3 && third.size() == 2);
+  CHECK(first.find(Name("Sword")) && !third.find(Name("Sword")) && third.find(Name("Club")));
+  CHECK(third.remove(Name("Sword")) == ErrorCode::ItemNotFound);
+  CHECK(world.arsenals[0].size() == 2 && !world.arsenals[0].find(Name("Club")));
+  CHECK(runCommands(world, "Show weapons Ann\n") == "Axe:25 Sword:15\n");
+}
+
+std::string weaponName(unsigned number) {
+  return std::string("w").append(std::to_string(number));
+}
+
+// Compares every version kept along a random series of adds and removes
+// with a std::map model of it. Thousands of names fill several trie levels,
+// and iteration must still follow name order.
+void testContainerMatchesModelAcrossVersions() {
+  Character owner(Name("Ann"), 100);
+  std::mt19937 random(3);
+  Container<Weapon> current;
+  std::map<std::string, int> model;
+  std::vector<std::pair<Container<Weapon>, std::map<std::string, int>>> versions;
+  for (int step = 0; step < 6000; ++step) {
+    std::string name = weaponName(random() % 3000);
+    if (random() % 3 == 0) {
+      bool held = model.erase(name) == 1;
+      CHECK((current.remove(Name(name)) == ErrorCode::Ok) == held);
+    } else {
+      int value = static_cast<int>(random() % 100) + 1;
+      CHECK(current.add(Weapon(owner, Name(name), value)) == ErrorCode::Ok);
+      model[name] = value;
+    }
+    if (step % 500 == 0)
+      versions.emplace_back(current, model);
+  }
+  versions.emplace_back(current, model);
+  for (const auto& [version, expected] : versions) {
+    CHECK(version.size() == expected.size());
+    std::vector<std::pair<std::string, int>> visited;
+    for (const auto& [name, weapon] : version)
+      visited.emplace_back(name.str(), weapon.getDamage());
+    std::vector<std::pair<std::string, int>> ordered(expected.begin(), expected.end());
+    CHECK(visited == ordered);
+    bool found = true;
+    for (unsigned i = 0; i < 3000; ++i) {
+      std::string name = weaponName(i);
+      std::optional<Weapon> weapon = version.find(Name(name));
+      auto entry = expected.find(name);
+      found = found && (entry == expected.end() ? !weapon : weapon && weapon->getDamage() == entry->second);
+    }
+    CHECK(found);
+  }
+}
+
+void testForkRejectsBadHandles() {
+  World world;
+  runCommands(world, sampleCommands);
+  WorldFork base(world);
+  WorldFork branch = base.fork();
+  CHECK(branch.use<Weapon>(0, 1, "Axe") == ErrorCode::Ok);
+  CHECK(branch.character(1).getHP() == 65 && base.character(1).getHP() == 90);
+  CHECK(branch.use<Weapon>(0, 3, "Axe") == ErrorCode::InvalidHandle);
+  CHECK(branch.use<Weapon>(7, 1, "Axe") == ErrorCode::InvalidHandle);
+  CHECK(branch.setCharacter(3, Character(Name("Dan"), 1)) == ErrorCode::InvalidHandle);
+  CHECK(branch.setContainer(3, ContainerWithMaxCapacity<Potion>(1)) == ErrorCode::InvalidHandle);
+  CHECK(branch.setCharacter(2, Character(Name("Cid"), 1)) == ErrorCode::Ok);
+  CHECK(branch.character(2).getHP() == 1 && base.character(2).getHP() == 70);
+}
+
+// Forks number their uses like a command log, so they roll what the log
+// would, and two branches taken from one point roll alike.
+void testForkRollsLikeTheLog() {
+  World world;
+  runCommands(world, sampleCommands);
+  world.randomSeed = 9;
+  giveRollingEffect(world, 0, "Sword");
+  World logged = world;
+  runCommands(logged, "Attack Ann Bob Sword\nAttack Ann Cid Sword\n");
+
+  WorldFork base(world);
+  CHECK(base.use<Weapon>(0, 1, "Sword") == ErrorCode::Ok);
+  WorldFork left = base.fork();
+  WorldFork right = base.fork();
+  CHECK(left.use<Weapon>(0, 2, "Sword") == ErrorCode::Ok);
+  CHECK(right.use<Weapon>(0, 2, "Sword") == ErrorCode::Ok);
+  CHECK(left.character(2).getHP() == right.character(2).getHP());
+  CHECK(left.character(1).getHP() == logged.characters[1].getHP());
+  CHECK(left.character(2).getHP() == logged.characters[2].getHP());
+
+  // Resuming after the first command continues the log's numbering.
+  World afterFirst = base.materialize();
+  WorldFork resumed(afterFirst, 1);
+  CHECK(resumed.use<Weapon>(0, 2, "Sword") == ErrorCode::Ok);
+  CHECK(resumed.character(2).getHP() == logged.characters[2].getHP());
+}
+
+}  // namespace
+
+int main() {
+  testVectorVersionsAreIndependent();
+  testVectorBuildsEveryDepth();
+  testContainerVersionsAreIndependent();
+  testContainerMatchesModelAcrossVersions();
+  testForkRejectsBadHandles();
+  testForkRollsLikeTheLog();
+  return testResult();
+}
@@ -0,0 +1,158 @@
+#include "game/shard.h"
+#include "game/command.h"
+#include "test_support.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::string serialOutput(World world, const std::vector<SessionEvent>& events) {
+  std::ostringstream out;
+  runSession(world, events, out);
+  return out.str() + runCommands(world, "Show characters\n");
+}
+std::string shardedOutput(World world, const std::vector<SessionEvent>& events, size_t shards) {
+  std::ostringstream out;
+  {
+    ShardCoordinator coordinator(world, shards);
+    coordinator.run(events, out, 500);
+  }
+  return out.str() + runCommands(world, "Show characters\n");
+}
+
+void testShardedSessionMatchesSerial() {
+  SyntheticSession session = generateSession(40, 3000, 5);
+  std::string expected = serialOutput(session.world, session.events);
+  CHECK(shardedOutput(session.world, session.events, 1) == expected);
+  CHECK(shardedOutput(session.world, session.events, 3) == expected);
+}
+
+void testHealthFormulasAreRefused() {
+  SyntheticSession session = generateSession(10, 200, 2);
+  CHECK(ShardCoordinator::supports(session.world));
+
+  // Rolls depend only on the seed and the sequence, so they shard fine.
+  World rolled = session.world;
+  std::optional<Weapon> weapon = rolled.arsenals[0].find(Name("weapon0"));
+  weapon->setEffect(std::make_shared<const Formula>(*Formula::compile("base + roll(6)")));
+  rolled.arsenals[0].remove(weapon->getName());
+  CHECK(rolled.arsenals[0].add(*weapon) == ErrorCode::Ok);
+  CHECK(ShardCoordinator::supports(rolled));
+  CHECK(shardedOutput(rolled, session.events, 2) == serialOutput(rolled, session.events));
+
+  World healthBased = session.world;
+  weapon->setEffect(std::make_shared<const Formula>(*Formula::compile("target_hp / 2")));
+  healthBased.arsenals[0].remove(weapon->getName());
+  CHECK(healthBased.arsenals[0].add(*weapon) == ErrorCode::Ok);
+  CHECK(!ShardCoordinator::supports(healthBased));
+  CHECK_THROWS(ShardCoordinator(healthBased, 2));
+
+  World spellFormula = session.world;
+  std::optional<Spell> spell = spellFormula.spellBooks[1].find(Name("spell0"));
+  spell->setEffect(std::make_shared<const Formula>(*Formula::compile("base")));
+  spellFormula.spellBooks[1].remove(spell->getName());
+  CHECK(spellFormula.spellBooks[1].add(*spell) == ErrorCode::Ok);
+  CHECK(!ShardCoordinator::supports(spellFormula));
+}
+
+void testShardedCommandsMatchSerial() {
+  std::string commands = std::string(sampleCommands) +
+                         "Attack Ann Bob Sword\n"
+                         "Attack Ann Cid Axe\n"
+                         "Drink Bob Bob Elixir\n"
+                         "Dialogue Ann 2 take that\n"
+                         "Cast Bob Cid Spark\n"
+                         "Attack Ann Nobody Sword\n"
+                         "Drink Bob Bob Elixir\n"
+                         "Query HP below 100\n"
+                         "Create character fighter Dan 60\n"
+                         "Create item weapon Dan Club 7\n"
+                         "Attack Dan Ann Club\n"
+                         "Cast Cid Dan Doom\n"
+                         "Cast Cid Ann Doom\n"
+                         "Show potions Bob\n"
+                         "Show spells Cid\n"
+                         "Query Owners Elixir\n"
+                         "Show characters\n";
+  World serial;
+  std::string expected = runCommands(serial, commands);
+  for (size_t shards : {1, 2, 4}) {
+    World sharded;
+    std::ostringstream out;
+    runShardedCommands(commands, sharded, out, shards);
+    CHECK(out.str() == expected);
+    CHECK(runCommands(sharded, "Show characters\n") == runCommands(serial, "Show characters\n"));
+  }
+}
+
+// Characters created while the workers run reach their shards, and the
+// workers' own state matches the coordinator's copy.
+void testWorkersFollowCreatedCharacters() {
+  World serial;
+  runCommands(serial, sampleCommands);
+  World sharded = serial;
+  std::string created = "Create character fighter Dan 60\n"
+                        "Create item weapon Dan Club 7\n"
+                        "Create item potion Dan Salve 4\n";
+  std::vector<SessionEvent> events;
+  for (uint64_t sequence = 0; sequence < 60; ++sequence)
+    events.push_back({sequence, static_cast<ItemKind>(sequence % 2), static_cast<uint32_t>(sequence % 4),
+                      static_cast<uint32_t>((sequence + 1) % 4), sequence % 2 == 0 ? "Club" : "Salve"});
+  std::ostringstream expected;
+  runCommands(serial, created);
+  runSession(serial, events, expected);
+
+  std::ostringstream out;
+  ShardCoordinator coordinator(sharded, 3);
+  {
+    std::ostringstream ignored;
+    CommandInterpreter interpreter(sharded, ignored);
+    interpreter.setObserver(&coordinator);
+    std::istringstream in(created);
+    interpreter.run(in);
+  }
+  coordinator.run(events, out, 7);
+  CHECK(out.str() == expected.str());
+  CHECK(runCommands(sharded, "Show characters\n") == runCommands(serial, "Show characters\n"));
+  size_t characters = 0;
+  for (size_t index = 0; index < 3; ++index) {
+    World shard = coordinator.shard(index);
+    for (uint32_t local = 0; local < shard.characters.size(); ++local) {
+      const Character& held = shard.characters[local];
+      for (uint32_t handle = 0; handle < sharded.characters.size(); ++handle) {
+        if (sharded.characters[handle].getName() != held.getName())
+          continue;
+        CHECK(shardOf(handle, 3) == index);
+        CHECK(held.getHP() == sharded.characters[handle].getHP());
+        CHECK(shard.medicalBags[local].size() == sharded.medicalBags[handle].size());
+      }
+    }
+    characters += shard.characters.size();
+  }
+  CHECK(characters == sharded.characters.size());
+}
+
+// A worker that has gone away is an error, not a SIGPIPE.
+void testSendToClosedSocketThrows() {
+  int pair[2];
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+  close(pair[1]);
+  CHECK_THROWS(sendBatch(pair[0], "U 0 0 Ann Bob Sword\n"));
+  close(pair[0]);
+}
+
+}  // namespace
+
+int main() {
+  testShardedSessionMatchesSerial();
+  testHealthFormulasAreRefused();
+  testShardedCommandsMatchSerial();
+  testWorkersFollowCreatedCharacters();
+  testSendToClosedSocketThrows();
+  return testResult();
+}
@@ -0,0 +1,14 @@
+# Runs PROGRAM on COMMANDS serially and with --shards SHARDS and fails unless
+# both print the same output.
+execute_process(COMMAND ${PROGRAM} --run ${COMMANDS} OUTPUT_VARIABLE serial RESULT_VARIABLE serial_status)
+execute_process(COMMAND ${PROGRAM} --run ${COMMANDS} --shards ${SHARDS} OUTPUT_VARIABLE sharded
+                RESULT_VARIABLE sharded_status)
+if(NOT serial_status EQUAL 0 OR NOT sharded_status EQUAL 0)
+  message(FATAL_ERROR "runs failed: serial ${serial_status}, sharded ${sharded_status}")
+endif()
+if(serial STREQUAL "")
+  message(FATAL_ERROR "the serial run printed nothing")
+endif()
+if(NOT serial STREQUAL sharded)
+  message(FATAL_ERROR "--shards ${SHARDS} output differs from the serial run")
+endif()
@@ -0,0 +1,139 @@
+#include "game/snapshot.h"
+#include "test_support.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+std::string snapshotOf(const World& world) {
+  std::ostringstream out;
+  SnapshotWriter(world).write(out);
+  return out.str();
+}
+bool rejects(const std::string& bytes) {
+  try {
+    SnapshotView(bytes.data(), bytes.size());
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+// Copies a valid snapshot, lets change edit it in place and reports whether
+// the edited copy is refused.
+bool rejectsEdit(const std::string& valid, const std::function<void(char*, SnapshotHeader&)>& change) {
+  std::string bytes = valid;
+  SnapshotHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  change(bytes.data(), header);
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  return rejects(bytes);
+}
+template <typename Record>
+Record* recordAt(char* data, uint64_t offset, size_t index) {
+  return reinterpret_cast<Record*>(data + offset) + index;
+}
+
+World sampleWorld() {
+  World world;
+  runCommands(world, sampleCommands);
+  world.randomSeed = 77;
+  std::optional<Weapon> sword = world.arsenals[0].find(Name("Sword"));
+  sword->setEffect(std::make_shared<const Formula>(*Formula::compile("base + roll(6)")));
+  world.arsenals[0].add(*sword);
+  std::optional<Potion> tonic = world.medicalBags[0].find(Name("Tonic"));
+  tonic->setUsed(true);
+  world.medicalBags[0].add(*tonic);
+  return world;
+}
+
+void testRoundTripKeepsState() {
+  World original = sampleWorld();
+  std::string bytes = snapshotOf(original);
+  World restored = SnapshotView(bytes.data(), bytes.size()).restore();
+
+  CHECK(restored.randomSeed == 77);
+  CHECK(SnapshotView(bytes.data(), bytes.size()).position().tick == 0);
+  std::ostringstream positioned;
+  SnapshotWriter(original, {12, 345}).write(positioned);
+  std::string positionedBytes = positioned.str();
+  SessionPosition position = SnapshotView(positionedBytes.data(), positionedBytes.size()).position();
+  CHECK(position.tick == 12 && position.nextSequence == 345);
+  CHECK(restored.characters.size() == original.characters.size());
+  std::string inventory = "Show characters\nShow weapons Ann\nShow potions Ann\nShow potions Bob\n"
+                          "Show spells Bob\nShow spells Cid\n";
+  CHECK(runCommands(restored, inventory) == runCommands(original, inventory));
+  CHECK(restored.medicalBags[0].find(Name("Tonic"))->wasUsed());
+  CHECK(!restored.medicalBags[1].find(Name("Elixir"))->wasUsed());
+  const Formula* effect = restored.arsenals[0].find(Name("Sword"))->getEffect();
+  CHECK(effect != nullptr && effect->getSource() == "base + roll(6)");
+  CHECK(restored.arsenals[0].find(Name("Axe"))->getEffect() == nullptr);
+  CHECK(restored.arsenals[0].getMaxCapacity() == 3 && restored.spellBooks[2].getMaxCapacity() == 10);
+
+  // Same seed, formulas and consumption state: the worlds play out alike.
+  std::string session = "Attack Ann Bob Sword\nAttack Ann Cid Sword\nDrink Ann Ann Tonic\nCast Cid Bob Doom\n"
+                        "Show characters\n";
+  CHECK(runCommands(restored, session) == runCommands(original, session));
+}
+
+void testMappedFileRoundTrip() {
+  World original = sampleWorld();
+  std::string path = temporaryPath("world.snap");
+  CHECK(saveSnapshot(original, path));
+  {
+    MappedSnapshot mapped(path);
+    SnapshotView view = mapped.view();
+    CHECK(view.characters().size() == 3);
+    CHECK(view.string(view.characters()[1].name) == "Bob");
+    World restored = view.restore();
+    CHECK(runCommands(restored, "Show characters\n") == "Ann:120 Bob:90 Cid:70\n");
+  }
+  std::remove(path.c_str());
+  CHECK_THROWS(MappedSnapshot(temporaryPath("missing.snap")));
+  CHECK(!saveSnapshot(original, temporaryPath("missing/world.snap")));
+}
+
+void testCorruptSnapshotsAreRejected() {
+  std::string valid = snapshotOf(sampleWorld());
+  CHECK(!rejects(valid));
+  CHECK(rejects(valid.substr(0, sizeof(SnapshotHeader) - 1)));
+  CHECK(rejects(valid.substr(0, valid.size() - 1)));
+  CHECK(rejectsEdit(valid, [](char*, SnapshotHeader& header) { header.version = 2; }));
+  CHECK(rejectsEdit(valid, [](char*, SnapshotHeader& header) { header.characterCount = 1u << 30; }));
+  CHECK(rejectsEdit(valid, [](char*, SnapshotHeader& header) { header.itemOffset += 1; }));
+  CHECK(rejectsEdit(valid, [](char*, SnapshotHeader& header) { header.containerOffset = ~0ull - 7; }));
+  CHECK(rejectsEdit(valid, [](char*, SnapshotHeader& header) { header.stringSize += 1; }));
+  CHECK(rejectsEdit(valid, [](char* data, SnapshotHeader& header) {
+    recordAt<ContainerRecord>(data, header.containerOffset, 0)->owner = header.characterCount;
+  }));
+  CHECK(rejectsEdit(valid, [](char* data, SnapshotHeader& header) {
+    recordAt<ContainerRecord>(data, header.containerOffset, 0)->itemCount = header.itemCount + 1;
+  }));
+  CHECK(rejectsEdit(valid, [](char* data, SnapshotHeader& header) {
+    recordAt<ContainerRecord>(data, header.containerOffset, 1)->kind = static_cast<ItemKind>(7);
+  }));
+  CHECK(rejectsEdit(valid, [](char* data, SnapshotHeader& header) {
+    recordAt<ItemRecord>(data, header.itemOffset, 0)->firstTarget = header.targetCount + 1;
+  }));
+  CHECK(rejectsEdit(valid, [](char* data, SnapshotHeader& header) {
+    recordAt<ItemRecord>(data, header.itemOffset, 0)->effect.offset = static_cast<uint32_t>(header.stringSize);
+    recordAt<ItemRecord>(data, header.itemOffset, 0)->effect.length = 1;
+  }));
+  CHECK(rejectsEdit(valid, [](char* data, SnapshotHeader& header) {
+    recordAt<CharacterRecord>(data, header.characterOffset, 2)->name.length = 40;
+  }));
+}
+
+}  // namespace
+
+int main() {
+  testRoundTripKeepsState();
+  testMappedFileRoundTrip();
+  testCorruptSnapshotsAreRejected();
+  return testResult();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "game/command.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+// Shared pieces of the behavior tests. CHECK reports a failed condition with
+// its location and lets the test go on, so one run lists every failure; the
+// exit status of testResult() tells CTest whether any check failed.
+inline int& failedChecks() {
+  static int count = 0;
+  return count;
+}
+#define CHECK(condition)                                                                  \
+  do {                                                                                    \
+    if (!(condition)) {                                                                   \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+      ++failedChecks();                                                                   \
+    }                                                                                     \
+  } while (false)
+#define CHECK_THROWS(expression)                                                              \
+  do {                                                                                        \
+    bool thrown = false;                                                                      \
+    try {                                                                                     \
+      (void)(expression);                                                                     \
+    } catch (...) {                                                                           \
+      thrown = true;                                                                          \
+    }                                                                                         \
+    if (!thrown) {                                                                            \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK_THROWS(" #expression ") failed\n"; \
+      ++failedChecks();                                                                       \
+    }                                                                                         \
+  } while (false)
+inline int testResult() {
+  return failedChecks() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// A path in the temporary directory that is unique to this test process.
+inline std::string temporaryPath(std::string_view name) {
+  return (std::filesystem::temp_directory_path() /
+          ("game_test_" + std::to_string(getpid()) + "_" + std::string(name)))
+      .string();
+}
+
+// Runs text commands on world and returns what they printed.
+inline std::string runCommands(World& world, std::string_view commands) {
+  std::ostringstream out;
+  CommandInterpreter interpreter(world, out);
+  std::istringstream in{std::string(commands)};
+  interpreter.run(in);
+  return out.str();
+}
+
+// Gives the weapon a formula that rolls, for checks that combat randomness
+// depends only on the seed and the command number.
+inline void giveRollingEffect(World& world, uint32_t owner, std::string_view weapon) {
+  std::optional<Weapon> item = world.arsenals[owner].find(Name(weapon));
+  item->setEffect(std::make_shared<const Formula>(*Formula::compile("base + roll(1000)")));
+  world.arsenals[owner].remove(item->getName());
+  world.arsenals[owner].add(*item);
+}
+
+// A small world with every item kind: fighters with weapons and potions and
+// an archer and wizard with spells.
+inline constexpr std::string_view sampleCommands =
+    "Create character fighter Ann 120\n"
+    "Create character archer Bob 90\n"
+    "Create character wizard Cid 70\n"
+    "Create item weapon Ann Sword 15\n"
+    "Create item weapon Ann Axe 25\n"
+    "Create item weapon Bob Bow 10\n"
+    "Create item potion Ann Tonic 20\n"
+    "Create item potion Bob Elixir 35\n"
+    "Create item potion Cid Brew 5\n"
+    "Create item spell Bob Spark 1 Cid\n"
+    "Create item spell Cid Doom 2 Ann Bob\n"
+    "Create item spell Cid Mist 0\n";
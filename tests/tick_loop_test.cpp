@@ -0,0 +1,171 @@
+#include "game/snapshot.h"
+#include "game/tick_loop.h"
+#include "test_support.h"
+
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t characterCount = 40;
+constexpr size_t eventsPerTick = 25;
+constexpr size_t tickCount = 12;
+
+SyntheticSession sampleSession() {
+  SyntheticSession session = generateSession(characterCount, eventsPerTick * tickCount, 5);
+  // Rolls make the checked output depend on the seed and the sequence numbers.
+  for (uint32_t owner = 0; owner < characterCount; ++owner)
+    giveRollingEffect(session.world, owner, "weapon0");
+  return session;
+}
+void enqueueTick(TickLoop& loop, const std::vector<SessionEvent>& events, size_t firstEvent) {
+  for (size_t i = firstEvent; i < firstEvent + eventsPerTick; ++i)
+    loop.enqueue(events[i]);
+}
+std::string healthOf(const World& world) {
+  std::string health;
+  for (const Character& character : world.characters)
+    health += std::to_string(character.getHP()) + ' ';
+  return health;
+}
+
+void testPercentilesComeFromTheSamples() {
+  LatencyRecorder empty;
+  CHECK(empty.percentile(0.5) == std::chrono::nanoseconds(0));
+  LatencyRecorder recorder(100);
+  for (int sample = 100; sample >= 1; --sample)
+    recorder.record(std::chrono::nanoseconds(sample));
+  CHECK(recorder.size() == 100);
+  CHECK(recorder.percentile(0.0) == std::chrono::nanoseconds(1));
+  CHECK(recorder.percentile(0.5) == std::chrono::nanoseconds(51));
+  CHECK(recorder.percentile(0.99) == std::chrono::nanoseconds(100));
+  CHECK(recorder.percentile(1.0) == std::chrono::nanoseconds(100));
+}
+
+// Each tick writes its output at once; together the ticks print what one
+// serial run of the same events does.
+void testTicksPrintWhatASerialRunDoes() {
+  SyntheticSession session = sampleSession();
+  World serial = session.world;
+  std::ostringstream expected;
+  runSession(serial, session.events, expected);
+
+  std::ostringstream out;
+  TickLoop loop(session.world, out, std::chrono::nanoseconds(0));
+  std::vector<size_t> written;
+  loop.run(tickCount, std::chrono::nanoseconds(0), [&](size_t tick) {
+    written.push_back(out.str().size());
+    enqueueTick(loop, session.events, tick * eventsPerTick);
+  });
+  CHECK(written.size() == tickCount && written[0] == 0);
+  CHECK(out.str() == expected.str());
+  CHECK(healthOf(session.world) == healthOf(serial));
+  CHECK(loop.getLatencies().size() == tickCount);
+  CHECK(loop.getOverruns() == tickCount);
+  std::ostringstream report;
+  loop.report(report);
+  CHECK(report.str().starts_with("12 ticks, p50 "));
+  CHECK(report.str().find("12 over the 0 us budget") != std::string::npos);
+}
+
+// Producers on other threads may enqueue while the loop ticks; every event
+// runs exactly once. Apart from deaths, which spells can still cause, each
+// event prints one line whatever order the producers interleave in.
+void testConcurrentProducersLoseNothing() {
+  SyntheticSession session = generateSession(characterCount, 3000, 5);
+  std::ostringstream out;
+  TickLoop loop(session.world, out, std::chrono::seconds(1));
+  std::atomic<size_t> finished{0};
+  std::vector<std::thread> producers;
+  for (size_t producer = 0; producer < 3; ++producer)
+    producers.emplace_back([&, producer] {
+      for (size_t event = producer; event < session.events.size(); event += 3)
+        loop.enqueue(session.events[event]);
+      ++finished;
+    });
+  while (finished < producers.size())
+    loop.tick();
+  for (std::thread& producer : producers)
+    producer.join();
+  loop.tick();
+  std::istringstream lines(out.str());
+  size_t eventLines = 0;
+  for (std::string line; std::getline(lines, line);)
+    eventLines += !line.ends_with(" has died...");
+  CHECK(eventLines == session.events.size());
+  CHECK(loop.getPosition().nextSequence == session.events.size());
+}
+
+void testPositionCountsTicksAndEvents() {
+  SyntheticSession session = sampleSession();
+  std::ostringstream out;
+  TickLoop loop(session.world, out, std::chrono::seconds(1));
+  loop.tick();
+  CHECK(loop.getPosition().tick == 1 && loop.getPosition().nextSequence == 0);
+  enqueueTick(loop, session.events, 0);
+  loop.tick();
+  CHECK(loop.getPosition().tick == 2 && loop.getPosition().nextSequence == eventsPerTick);
+  loop.resumeAt({7, 300});
+  loop.tick();
+  CHECK(loop.getPosition().tick == 8 && loop.getPosition().nextSequence == 300);
+}
+
+// A run resumed from a checkpoint prints and ends where the uninterrupted
+// run does.
+void testRunResumesFromCheckpoint() {
+  SyntheticSession reference = sampleSession();
+  std::ostringstream referenceOut;
+  std::vector<size_t> outputAfterTick{0};
+  TickLoop referenceLoop(reference.world, referenceOut, std::chrono::seconds(1));
+  for (size_t tick = 0; tick < tickCount; ++tick) {
+    enqueueTick(referenceLoop, reference.events, tick * eventsPerTick);
+    referenceLoop.tick();
+    outputAfterTick.push_back(referenceOut.str().size());
+  }
+
+  SyntheticSession session = sampleSession();
+  std::string path = temporaryPath("tick.snap");
+  std::ostringstream out;
+  {
+    TickLoop loop(session.world, out, std::chrono::seconds(1));
+    loop.checkpointEvery(4, path);
+    for (size_t tick = 0; tick < 6; ++tick) {
+      enqueueTick(loop, session.events, tick * eventsPerTick);
+      loop.tick();
+      loop.finishCheckpoints();
+    }
+  }
+  MappedSnapshot checkpoint(path);
+  SnapshotView view = checkpoint.view();
+  SessionPosition position = view.position();
+  CHECK(position.tick == 4 && position.nextSequence == 4 * eventsPerTick);
+  CHECK(view.randomSeed() == 5);
+
+  World resumed = view.restore();
+  std::ostringstream resumedOut;
+  TickLoop loop(resumed, resumedOut, std::chrono::seconds(1));
+  loop.resumeAt(position);
+  for (size_t event = position.nextSequence; event < session.events.size(); event += eventsPerTick) {
+    enqueueTick(loop, session.events, event);
+    loop.tick();
+  }
+  CHECK(loop.getPosition().tick == tickCount && loop.getPosition().nextSequence == session.events.size());
+  CHECK(resumedOut.str() == referenceOut.str().substr(outputAfterTick[position.tick]));
+  CHECK(healthOf(resumed) == healthOf(reference.world));
+  std::remove(path.c_str());
+}
+
+}  // namespace
+
+int main() {
+  testPercentilesComeFromTheSamples();
+  testTicksPrintWhatASerialRunDoes();
+  testConcurrentProducersLoseNothing();
+  testPositionCountsTicksAndEvents();
+  testRunResumesFromCheckpoint();
+  return testResult();
+}
@@ -0,0 +1,113 @@
+#include "game/undo_log.h"
+#include "test_support.h"
+
+#include <string>
+
+namespace {
+
+std::string weaponsOf(World& world, std::string_view owner) {
+  return runCommands(world, "Show weapons " + std::string(owner) + "\n");
+}
+
+void testOverwriteIsUndone() {
+  World world;
+  runCommands(world, sampleCommands);
+  UndoLog log(world);
+  CHECK(log.add(0, Weapon(world.characters[0], Name("Sword"), 40)) == ErrorCode::Ok);
+  CHECK(weaponsOf(world, "Ann") == "Axe:25 Sword:40\n");
+  CHECK(log.undo());
+  CHECK(weaponsOf(world, "Ann") == "Axe:25 Sword:15\n");
+  CHECK(log.redo());
+  CHECK(weaponsOf(world, "Ann") == "Axe:25 Sword:40\n");
+  CHECK(log.undo());
+  CHECK(!log.undo());
+  CHECK(weaponsOf(world, "Ann") == "Axe:25 Sword:15\n");
+}
+
+void testUseIsUndone() {
+  World world;
+  runCommands(world, sampleCommands);
+  UndoLog log(world);
+  CHECK(log.use<Weapon>(0, 1, "Axe") == ErrorCode::Ok);
+  CHECK(log.use<Potion>(1, 1, "Elixir") == ErrorCode::Ok);
+  CHECK(runCommands(world, "Show characters\nShow potions Bob\n") == "Ann:120 Bob:100 Cid:70\n\n");
+  CHECK(log.undo());
+  CHECK(runCommands(world, "Show characters\nShow potions Bob\n") == "Ann:120 Bob:65 Cid:70\nElixir:35\n");
+  CHECK(log.undo());
+  CHECK(runCommands(world, "Show characters\n") == "Ann:120 Bob:90 Cid:70\n");
+  CHECK(log.redo() && log.redo() && !log.redo());
+  CHECK(runCommands(world, "Show characters\n") == "Ann:120 Bob:100 Cid:70\n");
+  CHECK(log.use<Weapon>(0, 1, "Bow") == ErrorCode::ItemNotFound);
+}
+
+void testFullRingForgetsWholeCommands() {
+  World world;
+  runCommands(world, sampleCommands);
+  UndoLog log(world, 3);
+  log.takeDamage(2, 10);
+  log.use<Potion>(1, 1, "Elixir");
+  log.use<Spell>(1, 2, "Spark");
+  CHECK(log.undo());
+  CHECK(!log.undo());
+  CHECK(runCommands(world, "Show characters\n") == "Ann:120 Bob:125 Cid:60\n");
+}
+
+void testEmptyRingStillUndoes() {
+  World world;
+  runCommands(world, sampleCommands);
+  UndoLog log(world, 0);
+  CHECK(log.use<Potion>(1, 1, "Elixir") == ErrorCode::Ok);
+  CHECK(log.undo());
+  CHECK(runCommands(world, "Show characters\nShow potions Bob\n") == "Ann:120 Bob:90 Cid:70\nElixir:35\n");
+}
+
+void testUsesRollLikeTheLog() {
+  World world;
+  runCommands(world, sampleCommands);
+  world.randomSeed = 4;
+  giveRollingEffect(world, 0, "Sword");
+  World logged = world;
+  runCommands(logged, "Attack Ann Bob Sword\nAttack Ann Bob Sword\n");
+
+  UndoLog log(world, 16);
+  CHECK(log.use<Weapon>(0, 1, "Sword") == ErrorCode::Ok);
+  int afterFirst = world.characters[1].getHP();
+  CHECK(log.use<Weapon>(0, 1, "Sword") == ErrorCode::Ok);
+  CHECK(world.characters[1].getHP() == logged.characters[1].getHP());
+  // Redo reapplies the recorded damage instead of rolling again.
+  CHECK(log.undo() && log.redo());
+  CHECK(world.characters[1].getHP() == logged.characters[1].getHP());
+  CHECK(log.undo());
+  CHECK(world.characters[1].getHP() == afterFirst);
+}
+
+// Entries hold handles, so undo still reaches the right character and
+// container after the world's vectors have grown and moved.
+void testUndoAfterWorldGrows() {
+  World world;
+  runCommands(world, sampleCommands);
+  UndoLog log(world);
+  CHECK(log.use<Potion>(1, 1, "Elixir") == ErrorCode::Ok);
+  std::string added;
+  for (int i = 0; i < 100; ++i)
+    added.append("Create character fighter W").append(std::to_string(i)).append(" 10\n");
+  runCommands(world, added);
+  CHECK(log.undo());
+  CHECK(runCommands(world, "Show characters\nShow potions Bob\n").starts_with("Ann:120 Bob:90 Cid:70 W0:10"));
+  CHECK(weaponsOf(world, "Bob") == "Bow:10\n");
+  CHECK(log.use<Weapon>(0, 103, "Axe") == ErrorCode::InvalidHandle);
+  CHECK(log.heal(103, 5) == ErrorCode::InvalidHandle);
+  CHECK(log.remove<Potion>(103, "Elixir") == ErrorCode::InvalidHandle);
+}
+
+}  // namespace
+
+int main() {
+  testOverwriteIsUndone();
+  testUseIsUndone();
+  testFullRingForgetsWholeCommands();
+  testEmptyRingStillUndoes();
+  testUsesRollLikeTheLog();
+  testUndoAfterWorldGrows();
+  return testResult();
+}
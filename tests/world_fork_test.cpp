@@ -0,0 +1,96 @@
+#include "game/world_fork.h"
+#include "test_support.h"
+
+#include <string>
+
+namespace {
+
+World sampleWorld() {
+  World world;
+  runCommands(world, sampleCommands);
+  return world;
+}
+// What the inventory commands print for world.
+std::string describe(World world) {
+  return runCommands(world, "Show characters\nShow weapons Ann\nShow potions Ann\nShow potions Bob\n"
+                            "Show spells Bob\nShow spells Cid\n");
+}
+
+void testBranchesDoNotSeeEachOther() {
+  World world = sampleWorld();
+  std::string before = describe(world);
+  WorldFork base(world);
+  WorldFork drinker = base.fork();
+  WorldFork caster = base.fork();
+  CHECK(drinker.use<Potion>(0, 0, "Tonic") == ErrorCode::Ok);
+  CHECK(caster.use<Spell>(2, 1, "Doom") == ErrorCode::Ok);
+
+  CHECK(!drinker.container<Potion>(0).find(Name("Tonic")) && caster.container<Potion>(0).find(Name("Tonic")));
+  CHECK(!caster.container<Spell>(2).find(Name("Doom")) && drinker.container<Spell>(2).find(Name("Doom")));
+  CHECK(drinker.character(1).getHP() == 90 && caster.character(1).getHP() == 0);
+  CHECK(describe(base.materialize()) == before);
+  CHECK(describe(world) == before);
+}
+
+// A branch plays out as the same commands do on a copy of the world.
+void testMaterializedBranchMatchesCommands() {
+  World world = sampleWorld();
+  WorldFork branch(world);
+  CHECK(branch.use<Weapon>(0, 1, "Axe") == ErrorCode::Ok);
+  CHECK(branch.use<Potion>(1, 1, "Elixir") == ErrorCode::Ok);
+  CHECK(branch.use<Spell>(1, 2, "Spark") == ErrorCode::Ok);
+  runCommands(world, "Attack Ann Bob Axe\nDrink Bob Bob Elixir\nCast Bob Cid Spark\n");
+  CHECK(describe(branch.materialize()) == describe(world));
+}
+
+void testForkOfBranchKeepsItsChanges() {
+  WorldFork base(sampleWorld());
+  WorldFork branch = base.fork();
+  CHECK(branch.use<Weapon>(0, 2, "Sword") == ErrorCode::Ok);
+  WorldFork nested = branch.fork();
+  CHECK(nested.use<Weapon>(0, 2, "Sword") == ErrorCode::Ok);
+  CHECK(base.character(2).getHP() == 70);
+  CHECK(branch.character(2).getHP() == 55);
+  CHECK(nested.character(2).getHP() == 40);
+}
+
+void testFailedUsesChangeNothing() {
+  World world = sampleWorld();
+  WorldFork branch(world);
+  CHECK(branch.use<Weapon>(0, 1, "Bow") == ErrorCode::ItemNotFound);
+  CHECK(branch.use<Potion>(0, 0, std::string(40, 'x')) == ErrorCode::ItemNotFound);
+  CHECK(branch.use<Spell>(1, 0, "Spark") != ErrorCode::Ok);
+  CHECK(describe(branch.materialize()) == describe(world));
+}
+
+// Enough characters for the vectors behind the fork to be several levels
+// deep; a change still reaches only its own slot.
+void testLargeWorldsShareUntouchedSlots() {
+  World world;
+  for (int i = 0; i < 5000; ++i)
+    world.characters.emplace_back(Name(std::string("c").append(std::to_string(i))), i + 1);
+  world.arsenals.assign(world.characters.size(), ContainerWithMaxCapacity<Weapon>(1));
+  world.medicalBags.assign(world.characters.size(), ContainerWithMaxCapacity<Potion>(1));
+  world.spellBooks.assign(world.characters.size(), ContainerWithMaxCapacity<Spell>(1));
+  WorldFork base(world);
+  WorldFork branch = base.fork();
+  for (uint32_t handle : {0u, 31u, 32u, 1023u, 1024u, 4999u})
+    CHECK(branch.setCharacter(handle, Character(Name("changed"), 0)) == ErrorCode::Ok);
+  bool untouched = true;
+  for (uint32_t handle = 0; handle < world.characters.size(); ++handle)
+    untouched = untouched && base.character(handle).getHP() == static_cast<int>(handle) + 1;
+  CHECK(untouched);
+  CHECK(branch.character(1024).getHP() == 0 && branch.character(1025).getHP() == 1026);
+  CHECK(branch.character(4999).getName() == Name("changed"));
+}
+
+}  // namespace
+
+int main() {
+  testBranchesDoNotSeeEachOther();
+  testMaterializedBranchMatchesCommands();
+  testForkOfBranchKeepsItsChanges();
+  testFailedUsesChangeNothing();
+  testLargeWorldsShareUntouchedSlots();
+  return testResult();
+}
@@ -0,0 +1,79 @@
+#include "game/world_index.h"
+#include "test_support.h"
+
+#include <climits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::string query(const WorldIndex& index, std::vector<std::string_view> words, ErrorCode expected = ErrorCode::Ok) {
+  std::ostringstream out;
+  CHECK(index.query(words, out) == expected);
+  return out.str();
+}
+
+void testQueriesFollowTheWorld() {
+  World world;
+  runCommands(world, sampleCommands);
+  WorldIndex index(world);
+  observeWorld(world, &index);
+  CHECK(query(index, {"HP", "below", "100"}) == "Cid:70 Bob:90\n");
+  CHECK(query(index, {"HP", "between", "90", "120"}) == "Bob:90 Ann:120\n");
+  CHECK(query(index, {"Owners", "Sword"}) == "Ann\n");
+  CHECK(query(index, {"Owners", "Nothing"}) == "\n");
+
+  runCommands(world, "Attack Ann Bob Axe\nDrink Bob Bob Elixir\n");
+  CHECK(query(index, {"HP", "below", "80"}) == "Cid:70\n");
+  CHECK(query(index, {"HP", "between", "100", "100"}) == "Bob:100\n");
+  CHECK(query(index, {"Owners", "Elixir"}) == "\n");
+  observeWorld(world, nullptr);
+}
+
+void testMalformedQueriesAreRejected() {
+  World world;
+  runCommands(world, sampleCommands);
+  WorldIndex index(world);
+  CHECK(query(index, {"HP", "below"}, ErrorCode::InvalidValue).empty());
+  CHECK(query(index, {"HP", "below", "ten"}, ErrorCode::InvalidValue).empty());
+  CHECK(query(index, {"HP", "between", "1"}, ErrorCode::InvalidValue).empty());
+  CHECK(query(index, {"HP", "above", "1"}, ErrorCode::InvalidValue).empty());
+  CHECK(query(index, {"Owners", "AnItemNameThatIsLongerThan31Bytes"}, ErrorCode::InvalidValue).empty());
+  CHECK(query(index, {}, ErrorCode::InvalidValue).empty());
+  // No HP is below the smallest int, and the bound does not overflow.
+  CHECK(query(index, {"HP", "below", std::to_string(INT_MIN)}) == "\n");
+}
+
+void testQueryCommand() {
+  World world;
+  std::string output = runCommands(world, std::string(sampleCommands) +
+                                              "Query HP below 100\n"
+                                              "Create character archer Dan 40\n"
+                                              "Create item weapon Dan Sword 5\n"
+                                              "Attack Ann Cid Axe\n"
+                                              "Query HP below 100\n"
+                                              "Query Owners Sword\n"
+                                              "Query HP below\n"
+                                              "Query HP between 1 2 3\n");
+  std::string_view expected =
+      "Cid:70 Bob:90\n"
+      "A new archer came to town, Dan.\n"
+      "Dan just obtained a new weapon called Sword.\n"
+      "Ann attacks Cid with their Axe!\n"
+      "Dan:40 Cid:45 Bob:90\n"
+      "Ann Dan\n"
+      "Error caught\n"
+      "Error caught\n";
+  CHECK(output.ends_with(expected));
+}
+
+}  // namespace
+
+int main() {
+  testQueriesFollowTheWorld();
+  testMalformedQueriesAreRejected();
+  testQueryCommand();
+  return testResult();
+}